@@ -0,0 +1,252 @@
+// thread_affinity.h
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Ubicación de hilos en núcleos y nodos NUMA. Lo comparten los tres
+// programas *_solucion (common/ está en sus rutas de include).
+//
+// CpuTopology lee qué CPUs tiene cada nodo (Linux: /sys/devices/system/node,
+// Windows: GetNumaNodeProcessorMask, solo el primer grupo de 64 CPUs) y se
+// queda con las que el proceso puede usar. Sin información de NUMA arma un
+// único nodo con todas las CPUs.
+//
+// AffinityPlan reparte los hilos numerados entre los nodos en round-robin
+// (el hilo i va al nodo i % nodos), así el productor i y el consumidor i
+// caen en el mismo nodo:
+//   Placement::None  sin fijar, decide el sistema operativo
+//   Placement::Core  cada hilo fijo a una CPU de su nodo
+//   Placement::Node  cada hilo libre entre las CPUs de su nodo
+enum class Placement { None, Core, Node };
+
+// "none", "core" o "node"
+inline Placement parse_placement(const std::string& s) {
+    if (s == "none") return Placement::None;
+    if (s == "core") return Placement::Core;
+    if (s == "node") return Placement::Node;
+    throw std::invalid_argument("pin: se esperaba none, core o node");
+}
+
+// "0-3,8,10-11" -> {0,1,2,3,8,10,11} (formato de cpulist de Linux)
+inline std::vector<int> parse_cpu_list(const std::string& s, char sep = ',') {
+    std::vector<int> cpus;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, sep)) {
+        if (item.empty()) continue;
+        std::size_t dash = item.find('-');
+        int first = std::stoi(item.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+        if (first < 0 || last < first) throw std::invalid_argument("lista de CPUs invalida: " + s);
+        for (int c = first; c <= last; ++c) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+// CPU en la que corre el hilo actual (-1 si no se sabe)
+inline int current_cpu() {
+#ifdef _WIN32
+    return (int)GetCurrentProcessorNumber();
+#else
+    return sched_getcpu();
+#endif
+}
+
+// Restringe el hilo actual a 'cpus'; false si el sistema lo rechazó
+inline bool pin_current_thread(const std::vector<int>& cpus) {
+    if (cpus.empty()) return false;
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (int c : cpus) {
+        if (c < (int)(8 * sizeof(DWORD_PTR))) mask |= (DWORD_PTR)1 << c;
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) {
+        if (c < CPU_SETSIZE) CPU_SET(c, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+class CpuTopology {
+public:
+    // 'only' (si no está vacía) limita la topología a esas CPUs
+    static CpuTopology detect(const std::vector<int>& only = {}) {
+        std::vector<bool> allowed = allowed_cpus();
+        if (!only.empty()) {
+            std::vector<bool> wanted(allowed.size(), false);
+            for (int c : only) {
+                if (c < (int)wanted.size()) wanted[c] = allowed[c];
+            }
+            allowed = wanted;
+        }
+
+        CpuTopology topo;
+        for (const auto& node : read_nodes()) {
+            std::vector<int> cpus;
+            for (int c : node) {
+                if (c < (int)allowed.size() && allowed[c]) cpus.push_back(c);
+            }
+            if (!cpus.empty()) topo.add_node(cpus);
+        }
+
+        if (topo.nodes_.empty()) {
+            // Sin NUMA conocido: un nodo con todas las CPUs permitidas
+            std::vector<int> cpus;
+            for (int c = 0; c < (int)allowed.size(); ++c) {
+                if (allowed[c]) cpus.push_back(c);
+            }
+            if (cpus.empty()) throw std::invalid_argument("ninguna de las CPUs pedidas esta disponible");
+            topo.add_node(cpus);
+        }
+        return topo;
+    }
+
+    std::size_t num_nodes() const { return nodes_.size(); }
+    const std::vector<int>& cpus(std::size_t node) const { return nodes_[node]; }
+
+    std::size_t num_cpus() const {
+        std::size_t n = 0;
+        for (const auto& node : nodes_) n += node.size();
+        return n;
+    }
+
+    // Nodo de la CPU (-1 si no pertenece a la topología)
+    int node_of(int cpu) const {
+        return cpu >= 0 && cpu < (int)node_of_.size() ? node_of_[cpu] : -1;
+    }
+
+    // "nodo0: 0-3, nodo1: 4-7"; 'node_label' reemplaza a "nodo" en los
+    // programas que escriben en inglés
+    std::string describe(const char* node_label = "nodo") const {
+        std::ostringstream oss;
+        for (std::size_t n = 0; n < nodes_.size(); ++n) {
+            oss << (n ? ", " : "") << node_label << n << ":";
+            const auto& cpus = nodes_[n];
+            for (std::size_t i = 0; i < cpus.size();) {
+                std::size_t j = i;
+                while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+                oss << (i ? "," : " ") << cpus[i];
+                if (j > i) oss << "-" << cpus[j];
+                i = j + 1;
+            }
+        }
+        return oss.str();
+    }
+
+private:
+    void add_node(const std::vector<int>& cpus) {
+        for (int c : cpus) {
+            if (c >= (int)node_of_.size()) node_of_.resize(c + 1, -1);
+            node_of_[c] = (int)nodes_.size();
+        }
+        nodes_.push_back(cpus);
+    }
+
+    // CPUs que el proceso puede usar, indexadas por número de CPU
+    static std::vector<bool> allowed_cpus() {
+        std::vector<bool> allowed;
+#ifdef _WIN32
+        DWORD_PTR process = 0, system = 0;
+        if (GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) {
+            for (int c = 0; c < (int)(8 * sizeof(DWORD_PTR)); ++c) {
+                allowed.push_back(((process >> c) & 1) != 0);
+            }
+        }
+#else
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int c = 0; c < CPU_SETSIZE; ++c) allowed.push_back(CPU_ISSET(c, &set) != 0);
+        }
+#endif
+        if (allowed.empty()) allowed.assign(std::max(1u, std::thread::hardware_concurrency()), true);
+        return allowed;
+    }
+
+    // CPUs de cada nodo NUMA según el sistema (vacío si no se sabe)
+    static std::vector<std::vector<int>> read_nodes() {
+        std::vector<std::vector<int>> nodes;
+#ifdef _WIN32
+        ULONG highest = 0;
+        if (!GetNumaHighestNodeNumber(&highest)) return nodes;
+        for (ULONG n = 0; n <= highest; ++n) {
+            ULONGLONG mask = 0;
+            if (!GetNumaNodeProcessorMask((UCHAR)n, &mask)) continue;
+            std::vector<int> cpus;
+            for (int c = 0; c < 64; ++c) {
+                if ((mask >> c) & 1) cpus.push_back(c);
+            }
+            nodes.push_back(cpus);
+        }
+#else
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string ids;
+        if (!online || !std::getline(online, ids)) return nodes;
+        for (int n : parse_cpu_list(ids)) {
+            std::ifstream in("/sys/devices/system/node/node" + std::to_string(n) + "/cpulist");
+            std::string list;
+            if (in && std::getline(in, list)) nodes.push_back(parse_cpu_list(list));
+        }
+#endif
+        return nodes;
+    }
+
+    std::vector<std::vector<int>> nodes_;
+    std::vector<int> node_of_;
+};
+
+class AffinityPlan {
+public:
+    AffinityPlan(Placement placement, CpuTopology topology)
+        : placement_(placement), topo_(std::move(topology)) {}
+
+    Placement placement() const { return placement_; }
+    const CpuTopology& topology() const { return topo_; }
+
+    // Nodo asignado al hilo 'index' de un rol (productor i, consumidor i, ...)
+    std::size_t node_for(int index) const { return (std::size_t)index % topo_.num_nodes(); }
+
+    // CPUs permitidas para ese hilo (vacío con Placement::None)
+    std::vector<int> cpus_for(int index) const {
+        if (placement_ == Placement::None) return {};
+        const auto& cpus = topo_.cpus(node_for(index));
+        if (placement_ == Placement::Node) return cpus;
+        // Core: los hilos de un nodo ocupan sus CPUs en orden
+        return { cpus[((std::size_t)index / topo_.num_nodes()) % cpus.size()] };
+    }
+
+    // Fija el hilo actual según el plan. true si quedó fijo (o no había
+    // que fijarlo).
+    bool apply(int index) const {
+        if (placement_ == Placement::None) return true;
+        return pin_current_thread(cpus_for(index));
+    }
+
+    // Nodo en el que corre ahora el hilo actual (-1 si no se sabe)
+    int current_node() const { return topo_.node_of(current_cpu()); }
+
+private:
+    Placement placement_;
+    CpuTopology topo_;
+};
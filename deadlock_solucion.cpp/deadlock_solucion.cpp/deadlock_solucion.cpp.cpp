@@ -20,6 +20,10 @@ namespace std {
 #include <chrono>
 #include <atomic>
 #include <algorithm>
+#include <string>
+#include <stdexcept>
+
+#include "thread_affinity.h"
 using namespace std;
 using Clock = chrono::steady_clock;
 using ms = chrono::milliseconds;
@@ -28,18 +32,20 @@ struct Account {
     int id;
     long long balance;
     std::mutex mtx;
+    int last_node = -1; // nodo NUMA del último hilo que la tocó (protegido por mtx)
 
     Account(const Account&) = delete;
     Account& operator=(const Account&) = delete;
 
     Account(Account&& other) noexcept
-        : id(other.id), balance(other.balance) {
+        : id(other.id), balance(other.balance), last_node(other.last_node) {
     }
 
     Account& operator=(Account&& other) noexcept {
         if (this != &other) {
             id = other.id;
             balance = other.balance;
+            last_node = other.last_node;
         }
         return *this;
     }
@@ -55,6 +61,21 @@ vector<vector<Transfer>> thread_transfers;
 atomic<int> transfers_completed{ 0 };
 mutex log_mtx;
 
+// Ubicación de los hilos (--pin=none|core|node, --cpus=0-3:8-11) y cuántas
+// veces una cuenta pasó de un nodo NUMA a otro entre dos transferencias
+AffinityPlan affinity(Placement::None, CpuTopology::detect());
+atomic<int> account_touches{ 0 };
+atomic<int> cross_node_touches{ 0 };
+
+// Llamar con el lock de la cuenta tomado
+void touch_account(Account& acc, int node) {
+    if (node >= 0 && acc.last_node >= 0) {
+        account_touches.fetch_add(1);
+        if (acc.last_node != node) cross_node_touches.fetch_add(1);
+    }
+    acc.last_node = node;
+}
+
 void log_event(int thread_no, const string& msg) {
     lock_guard<mutex> lg(log_mtx);
     auto now = chrono::system_clock::now();
@@ -81,6 +102,9 @@ void do_transfer_nodl(int thread_no) {
         unique_lock<mutex> lk2(accounts[high].mtx, std::defer_lock);
         std::lock(lk1, lk2);
         log_event(thread_no, "Acquired both locks (" + to_string(low) + "," + to_string(high) + ")");
+        int node = affinity.current_node();
+        touch_account(accounts[low], node);
+        touch_account(accounts[high], node);
 
         if (accounts[a].balance >= t.amount) {
             accounts[a].balance -= t.amount;
@@ -98,7 +122,68 @@ void do_transfer_nodl(int thread_no) {
     log_event(thread_no, "Finished its transfers");
 }
 
-int main() {
+// Transfers/s of 'threads' threads doing random transfers between 5
+// accounts with the same ordered locking, without logging or sleeping (the
+// timed run above mostly measures its 20 ms pauses, not the placement)
+double measure_transfers(int threads, int transfers_per_thread) {
+    vector<Account> accs;
+    for (int i = 0; i < 5; i++) accs.emplace_back(i, 1000000);
+    vector<thread> workers;
+    auto start = Clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&accs, t, transfers_per_thread] {
+            affinity.apply(t);
+            unsigned x = 2463534242u + 7919u * (unsigned)t;
+            for (int i = 0; i < transfers_per_thread; i++) {
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                int a = (int)(x % 5), b = (int)((x >> 8) % 4);
+                if (b >= a) b++;
+                unique_lock<mutex> lk1(accs[min(a, b)].mtx, std::defer_lock);
+                unique_lock<mutex> lk2(accs[max(a, b)].mtx, std::defer_lock);
+                std::lock(lk1, lk2);
+                int amount = 1 + (int)((x >> 16) & 15);
+                if (accs[a].balance >= amount) {
+                    accs[a].balance -= amount;
+                    accs[b].balance += amount;
+                }
+            }
+            });
+    }
+    for (auto& w : workers) w.join();
+    double secs = chrono::duration<double>(Clock::now() - start).count();
+    return secs > 0 ? threads * (double)transfers_per_thread / secs : 0.0;
+}
+
+int main(int argc, char** argv) {
+    Placement placement = Placement::None;
+    vector<int> cpus;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        try {
+            if (arg.rfind("--pin=", 0) == 0)       placement = parse_placement(arg.substr(6));
+            else if (arg.rfind("--cpus=", 0) == 0) cpus = parse_cpu_list(arg.substr(7), ':');
+            else {
+                cerr << "Error: unknown option: " << arg << "\n";
+                return 1;
+            }
+        }
+        catch (const logic_error&) {
+            // thread_affinity.h reports in Spanish; keep this program's output in English
+            cerr << "Error: invalid value: " << arg << "\n";
+            return 1;
+        }
+    }
+    // Read the topology once, after all options are known
+    try {
+        affinity = AffinityPlan(placement, CpuTopology::detect(cpus));
+    }
+    catch (const logic_error&) {
+        cerr << "Error: none of the requested CPUs is available\n";
+        return 1;
+    }
+
     for (int i = 0; i < 5; i++) accounts.push_back({ i, (long long)1000 * (i + 1) });
     thread_transfers.resize(10);
     thread_transfers[0] = { {0,1,200},{1,2,300},{2,0,150} };
@@ -114,8 +199,12 @@ int main() {
 
     vector<thread> threads;
     auto start = Clock::now();
+    atomic<int> pin_failures{ 0 };
     for (int i = 1; i <= 10; i++) {
-        threads.emplace_back(do_transfer_nodl, i);
+        threads.emplace_back([i, &pin_failures] {
+            if (!affinity.apply(i - 1)) pin_failures.fetch_add(1);
+            do_transfer_nodl(i);
+            });
     }
     for (auto& th : threads) if (th.joinable()) th.join();
     auto end = Clock::now();
@@ -124,6 +213,13 @@ int main() {
     cout << "\n== Summary ==\n";
     cout << "Transfers completed: " << transfers_completed.load() << " / 30\n";
     cout << "Execution time (ms): " << elapsed << "\n";
+    cout << "Throughput without sleeps (transfers/s, 10 threads): " << fixed << setprecision(0)
+        << measure_transfers(10, 200000) << "\n";
+    cout.unsetf(ios::fixed);
+    cout << "Placement: " << (placement == Placement::None ? "none" : placement == Placement::Core ? "core" : "node")
+        << " (" << affinity.topology().describe("node") << ")"
+        << (pin_failures.load() > 0 ? ", unpinned threads: " + to_string(pin_failures.load()) : "") << "\n";
+    cout << "Cross-node account handoffs: " << cross_node_touches.load() << " / " << account_touches.load() << "\n";
     cout << "Final balances:\n";
     for (auto& a : accounts) cout << "Account " << a.id << " = $" << a.balance << "\n";
 
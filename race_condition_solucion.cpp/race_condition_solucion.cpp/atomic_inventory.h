@@ -0,0 +1,113 @@
+// atomic_inventory.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+// Inventario sin locks: el stock de cada producto es un std::atomic<int>
+// en su propia línea de caché.
+//
+// Con `int stock[10]` los 10 productos entran en una o dos líneas de 64
+// bytes: dos hilos que venden productos distintos igual se pelean la
+// línea (false sharing). Acá cada StockSlot ocupa 64 bytes.
+//
+//   reabastecer  fetch_add
+//   vender       sin guarda: fetch_sub (no hay nada que comprobar)
+//                con guarda: bucle CAS que solo descuenta si alcanza el
+//                stock; si no alcanza no toca nada y devuelve false
+//
+// La lectura, la comprobación y la escritura son una sola operación
+// atómica: no hace falta un mutex para que no se pierdan actualizaciones.
+//
+// 'Align' es la alineación de cada producto: AtomicInventory usa una línea
+// de caché; DenseAtomicInventory los deja contiguos (solo para medir el
+// false sharing en el benchmark).
+template <std::size_t Align>
+class BasicAtomicInventory {
+public:
+    BasicAtomicInventory(std::size_t products, int initial_stock)
+        : size_(products), slots_(std::make_unique<StockSlot[]>(products))
+    {
+        reset(initial_stock);
+    }
+
+    void reset(int initial_stock) {
+        for (std::size_t i = 0; i < size_; ++i) slots_[i].value.store(initial_stock, std::memory_order_relaxed);
+    }
+
+    std::size_t size() const { return size_; }
+    int stock(int product_id) const { return slots_[product_id].value.load(std::memory_order_acquire); }
+
+    // Con non_negative, false (y el stock intacto) si no hay 'quantity'
+    // unidades
+    bool vender(int product_id, int quantity, bool non_negative = false) {
+        std::atomic<int>& s = slots_[product_id].value;
+        if (!non_negative) {
+            s.fetch_sub(quantity, std::memory_order_acq_rel);
+            return true;
+        }
+        int current = s.load(std::memory_order_relaxed);
+        do {
+            if (current < quantity) return false;
+            // Si otro hilo cambió el stock, 'current' se actualiza y se reintenta
+        } while (!s.compare_exchange_weak(current, current - quantity,
+            std::memory_order_acq_rel, std::memory_order_relaxed));
+        return true;
+    }
+
+    void reabastecer(int product_id, int quantity) {
+        slots_[product_id].value.fetch_add(quantity, std::memory_order_acq_rel);
+    }
+
+private:
+    struct alignas(Align) StockSlot {
+        std::atomic<int> value{ 0 };
+    };
+
+    std::size_t size_;
+    std::unique_ptr<StockSlot[]> slots_;
+};
+
+constexpr std::size_t CACHE_LINE = 64;
+using AtomicInventory = BasicAtomicInventory<CACHE_LINE>;
+using DenseAtomicInventory = BasicAtomicInventory<alignof(std::atomic<int>)>;
+static_assert(sizeof(std::atomic<int>) <= CACHE_LINE, "un producto por linea de cache");
+
+// La versión con mutex por producto, con la misma distribución en memoria
+// que los arreglos globales (stock y mutex densos). Solo para comparar en
+// el benchmark.
+class MutexInventory {
+public:
+    MutexInventory(std::size_t products, int initial_stock)
+        : size_(products),
+        stock_(std::make_unique<int[]>(products)),
+        mutex_(std::make_unique<std::mutex[]>(products))
+    {
+        for (std::size_t i = 0; i < size_; ++i) stock_[i] = initial_stock;
+    }
+
+    std::size_t size() const { return size_; }
+
+    int stock(int product_id) {
+        std::lock_guard<std::mutex> lock(mutex_[product_id]);
+        return stock_[product_id];
+    }
+
+    bool vender(int product_id, int quantity, bool non_negative = false) {
+        std::lock_guard<std::mutex> lock(mutex_[product_id]);
+        if (non_negative && stock_[product_id] < quantity) return false;
+        stock_[product_id] -= quantity;
+        return true;
+    }
+
+    void reabastecer(int product_id, int quantity) {
+        std::lock_guard<std::mutex> lock(mutex_[product_id]);
+        stock_[product_id] += quantity;
+    }
+
+private:
+    std::size_t size_;
+    std::unique_ptr<int[]> stock_;
+    std::unique_ptr<std::mutex[]> mutex_;
+};
@@ -0,0 +1,183 @@
+// hot_inventory.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Inventario con mutex por producto que detecta los productos "calientes"
+// (muchos hilos sobre el mismo mutex, como en una venta flash) y los pasa a
+// contadores por núcleo.
+//
+// Producto frío: igual que MutexInventory, pero el mutex se pide primero con
+// try_lock. Cada vez que está ocupado se cuenta una espera; si en una
+// ventana de 'window' operaciones hay 'hot_threshold' esperas o más, el
+// producto pasa a caliente (y queda así hasta reset).
+//
+// Producto caliente: su stock es 'central' (bajo el mutex) más un saldo por
+// franja. Cada hilo usa siempre la misma franja, en su propia línea de caché.
+//
+//   reabastecer  fetch_add sobre el saldo de su franja, sin mutex
+//   vender       CAS sobre el saldo de su franja si alcanza; si no, toma el
+//                mutex y pasa su saldo a 'central'. Si con eso alcanza,
+//                descuenta de 'central' sin tocar las demás franjas; si no,
+//                junta también las otras (exchange a 0) y decide con el
+//                stock exacto. Después le asigna a su franja una parte de
+//                lo que queda en 'central'
+//
+// Con la guarda (non_negative) una venta solo descuenta unidades que existen
+// en su franja o en 'central', así que el stock nunca queda negativo. Cerca
+// del límite las partes que se reparten son menores que MIN_GRANT y no se
+// reparte nada: todas las ventas pasan por el mutex con el stock exacto.
+class HotInventory {
+public:
+    static constexpr int WINDOW = 1024;
+    static constexpr int MIN_GRANT = 8;
+
+    // 'hot_threshold' = 0 pone todos los productos en modo caliente desde el
+    // inicio; 'stripes' se redondea a potencia de 2 (0 = núcleos del equipo).
+    // Con pocas operaciones por producto conviene una ventana chica
+    HotInventory(std::size_t products, int initial_stock, int hot_threshold = 32, std::size_t stripes = 0,
+        int window = WINDOW)
+        : size_(products), hot_threshold_(hot_threshold), window_(window > 0 ? window : 1)
+    {
+        if (stripes == 0) stripes = std::thread::hardware_concurrency();
+        std::size_t n = 1;
+        while (n < stripes) n <<= 1;
+        stripes_ = n;
+        products_ = std::make_unique<Product[]>(products);
+        deltas_ = std::make_unique<Stripe[]>(products * stripes_);
+        reset(initial_stock);
+    }
+
+    // No es seguro con otros hilos operando. Con 'keep_detection' solo se
+    // repone el stock: los productos calientes siguen calientes y la ventana
+    // sigue contando, para detectar sobre varias corridas cortas
+    void reset(int initial_stock, bool keep_detection = false) {
+        for (std::size_t i = 0; i < size_; ++i) {
+            Product& p = products_[i];
+            p.central = initial_stock;
+            if (!keep_detection) {
+                p.ops = 0;
+                p.waits.store(0, std::memory_order_relaxed);
+                p.hot.store(hot_threshold_ == 0, std::memory_order_relaxed);
+            }
+            for (std::size_t s = 0; s < stripes_; ++s) stripe(i, s).store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t size() const { return size_; }
+    std::size_t stripes() const { return stripes_; }
+    bool is_hot(int product_id) const { return products_[product_id].hot.load(std::memory_order_relaxed); }
+
+    std::size_t hot_products() const {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < size_; ++i) n += is_hot((int)i);
+        return n;
+    }
+
+    // Stock exacto: 'central' más los saldos de todas las franjas
+    int stock(int product_id) {
+        Product& p = products_[product_id];
+        std::lock_guard<std::mutex> lock(p.mtx);
+        p.central += fold(product_id);
+        return p.central;
+    }
+
+    bool vender(int product_id, int quantity, bool non_negative = false) {
+        Product& p = products_[product_id];
+        if (p.hot.load(std::memory_order_relaxed)) {
+            std::atomic<int>& mine = stripe(product_id, my_stripe());
+            if (!non_negative) {
+                mine.fetch_sub(quantity, std::memory_order_relaxed);
+                return true;
+            }
+            int current = mine.load(std::memory_order_relaxed);
+            while (current >= quantity) {
+                if (mine.compare_exchange_weak(current, current - quantity, std::memory_order_relaxed)) return true;
+            }
+
+            // Sin saldo en la franja: primero se recarga desde 'central'; solo
+            // si no alcanza se les quita el saldo a las demás franjas
+            std::lock_guard<std::mutex> lock(p.mtx);
+            p.central += mine.exchange(0, std::memory_order_relaxed);
+            if (p.central < quantity) {
+                p.central += fold(product_id);
+                if (p.central < quantity) return false;
+            }
+            p.central -= quantity;
+            int grant = p.central / (int)(2 * stripes_);
+            if (grant >= MIN_GRANT) {
+                p.central -= grant;
+                mine.fetch_add(grant, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lock = acquire(p);
+        if (non_negative && p.central < quantity) return false;
+        p.central -= quantity;
+        return true;
+    }
+
+    void reabastecer(int product_id, int quantity) {
+        Product& p = products_[product_id];
+        if (p.hot.load(std::memory_order_relaxed)) {
+            stripe(product_id, my_stripe()).fetch_add(quantity, std::memory_order_relaxed);
+            return;
+        }
+        std::unique_lock<std::mutex> lock = acquire(p);
+        p.central += quantity;
+    }
+
+private:
+    struct alignas(64) Product {
+        std::mutex mtx;
+        int central = 0;
+        int ops = 0;                     // operaciones en la ventana (bajo mtx)
+        std::atomic<int> waits{ 0 };     // try_lock fallidos en la ventana
+        std::atomic<bool> hot{ false };
+    };
+
+    struct alignas(64) Stripe {
+        std::atomic<int> value{ 0 };
+    };
+
+    std::atomic<int>& stripe(std::size_t product_id, std::size_t s) { return deltas_[product_id * stripes_ + s].value; }
+
+    // Franja fija por hilo, asignada en orden de llegada
+    std::size_t my_stripe() const {
+        static std::atomic<std::size_t> next{ 0 };
+        thread_local std::size_t id = next.fetch_add(1, std::memory_order_relaxed);
+        return id & (stripes_ - 1);
+    }
+
+    // Con el mutex del producto tomado: saca los saldos de las franjas
+    int fold(std::size_t product_id) {
+        int sum = 0;
+        for (std::size_t s = 0; s < stripes_; ++s) sum += stripe(product_id, s).exchange(0, std::memory_order_relaxed);
+        return sum;
+    }
+
+    // Toma el mutex de un producto frío y cuenta si tuvo que esperar
+    std::unique_lock<std::mutex> acquire(Product& p) {
+        std::unique_lock<std::mutex> lock(p.mtx, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            p.waits.fetch_add(1, std::memory_order_relaxed);
+            lock.lock();
+        }
+        if (++p.ops == window_) {
+            if (p.waits.exchange(0, std::memory_order_relaxed) >= hot_threshold_) p.hot.store(true, std::memory_order_relaxed);
+            p.ops = 0;
+        }
+        return lock;
+    }
+
+    std::size_t size_;
+    int hot_threshold_;
+    int window_;
+    std::size_t stripes_ = 1;
+    std::unique_ptr<Product[]> products_;
+    std::unique_ptr<Stripe[]> deltas_;
+};
@@ -0,0 +1,138 @@
+// order_inventory.h
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+// Una línea de un pedido: 'quantity' unidades de 'product_id'
+struct OrderLine {
+    int product_id;
+    int quantity;
+};
+
+// Las líneas ordenadas por producto y con los productos repetidos sumados.
+// Tomar los mutex en este orden (siempre de menor a mayor id) evita el
+// deadlock entre dos pedidos que comparten productos: ninguno puede tener
+// un mutex que el otro necesita antes que los que ya tomó.
+inline std::vector<OrderLine> normalize_order(std::span<const OrderLine> lines) {
+    std::vector<OrderLine> sorted(lines.begin(), lines.end());
+    std::sort(sorted.begin(), sorted.end(),
+        [](const OrderLine& a, const OrderLine& b) { return a.product_id < b.product_id; });
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < sorted.size(); ++i) {
+        if (n > 0 && sorted[n - 1].product_id == sorted[i].product_id) sorted[n - 1].quantity += sorted[i].quantity;
+        else sorted[n++] = sorted[i];
+    }
+    sorted.resize(n);
+    return sorted;
+}
+
+enum class OrderResult { Committed, OutOfStock, Conflict };
+
+// Reserva todo o nada con los mutex tomados en orden creciente; la usan
+// OrderInventory::place_order y place_order del inventario global.
+// mutex_of(id) da el mutex del producto; con todos tomados, available(id)
+// da su stock y take(id, cantidad) lo descuenta. Si alguna línea no
+// alcanza no se llama a take para ninguna.
+template <class MutexOf, class Available, class Take>
+OrderResult place_order_sorted(std::span<const OrderLine> lines, MutexOf mutex_of, Available available, Take take) {
+    std::vector<OrderLine> order = normalize_order(lines);
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(order.size());
+    for (const OrderLine& l : order) locks.emplace_back(mutex_of(l.product_id));
+
+    for (const OrderLine& l : order) {
+        if (available(l.product_id) < l.quantity) return OrderResult::OutOfStock;
+    }
+    for (const OrderLine& l : order) take(l.product_id, l.quantity);
+    return OrderResult::Committed;
+}
+
+// Inventario para pedidos de varias líneas, todo o nada: o se descuentan
+// todas las líneas o no se toca ningún stock.
+//
+//   place_order             toma los mutex de los productos del pedido en
+//                           orden creciente, comprueba todo y descuenta.
+//                           Nunca aborta por concurrencia, pero mantiene
+//                           tomados todos los mutex mientras comprueba.
+//   place_order_optimistic  lee stock y versión de cada producto sin
+//                           locks; si alcanza, toma los mutex (en orden) y
+//                           confirma solo si ninguna versión cambió. Si
+//                           otro pedido confirmó antes sobre un producto
+//                           común devuelve Conflict sin descontar nada.
+//
+// Cada producto ocupa su propia línea de caché.
+class OrderInventory {
+public:
+    OrderInventory(std::size_t products, int initial_stock)
+        : size_(products), slots_(std::make_unique<Slot[]>(products))
+    {
+        for (std::size_t i = 0; i < size_; ++i) slots_[i].stock.store(initial_stock, std::memory_order_relaxed);
+    }
+
+    std::size_t size() const { return size_; }
+
+    int stock(int product_id) {
+        std::lock_guard<std::mutex> lock(slots_[product_id].mtx);
+        return slots_[product_id].stock.load(std::memory_order_relaxed);
+    }
+
+    OrderResult place_order(std::span<const OrderLine> lines) {
+        return place_order_sorted(lines,
+            [this](int id) -> std::mutex& { return slots_[id].mtx; },
+            [this](int id) { return slots_[id].stock.load(std::memory_order_relaxed); },
+            [this](int id, int quantity) { commit_line(slots_[id], quantity); });
+    }
+
+    OrderResult place_order_optimistic(std::span<const OrderLine> lines) {
+        std::vector<OrderLine> order = normalize_order(lines);
+        std::vector<std::uint64_t> seen(order.size());
+
+        // Lectura sin locks. La versión se lee antes que el stock: si el
+        // stock leído ya es de una confirmación posterior, la versión habrá
+        // cambiado al validar.
+        bool enough = true;
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            Slot& s = slots_[order[i].product_id];
+            seen[i] = s.version.load(std::memory_order_acquire);
+            if (s.stock.load(std::memory_order_relaxed) < order[i].quantity) enough = false;
+        }
+
+        std::vector<std::unique_lock<std::mutex>> locks;
+        locks.reserve(order.size());
+        for (const OrderLine& l : order) locks.emplace_back(slots_[l.product_id].mtx);
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            if (slots_[order[i].product_id].version.load(std::memory_order_relaxed) != seen[i]) return OrderResult::Conflict;
+        }
+        if (!enough) return OrderResult::OutOfStock;
+        for (const OrderLine& l : order) commit_line(slots_[l.product_id], l.quantity);
+        return OrderResult::Committed;
+    }
+
+    void reabastecer(int product_id, int quantity) {
+        Slot& s = slots_[product_id];
+        std::lock_guard<std::mutex> lock(s.mtx);
+        commit_line(s, -quantity);
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::mutex mtx;
+        std::atomic<int> stock{ 0 };
+        std::atomic<std::uint64_t> version{ 0 };
+    };
+
+    // Con el mutex del producto tomado
+    static void commit_line(Slot& s, int quantity) {
+        s.stock.store(s.stock.load(std::memory_order_relaxed) - quantity, std::memory_order_relaxed);
+        s.version.store(s.version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    std::size_t size_;
+    std::unique_ptr<Slot[]> slots_;
+};
@@ -5,6 +5,23 @@
 #include <chrono>
 #include <random>
 #include <mutex>  // std::mutex, std::lock_guard
+#include <atomic>
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+#include <iomanip>
+#include <unordered_map>
+#include <span>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include "thread_affinity.h"
+#include "atomic_inventory.h"
+#include "sku_inventory.h"
+#include "order_inventory.h"
+#include "hot_inventory.h"
+#include "worker_pool.h"
 
 using namespace std;
 
@@ -16,6 +33,40 @@ int stock[NUM_PRODUCTS];
 // Un mutex por producto
 std::mutex product_mutex[NUM_PRODUCTS];
 
+// Alternativa sin locks (--backend=atomic, ver atomic_inventory.h) y con
+// combinación de productos calientes (--backend=hot, ver hot_inventory.h).
+// Con --guard las ventas que dejarían el stock negativo se rechazan.
+// Cada corrida tiene solo 20 operaciones, así que hot_stock detecta con una
+// ventana de HOT_WINDOW operaciones por producto y conserva la detección
+// entre corridas (reset con keep_detection).
+enum class StockBackend { Mutex, Atomic, Hot };
+StockBackend backend = StockBackend::Mutex;
+bool non_negative = false;
+const int HOT_WINDOW = 4;
+const int HOT_THRESHOLD = 1;
+AtomicInventory atomic_stock(NUM_PRODUCTS, INITIAL_STOCK);
+HotInventory hot_stock(NUM_PRODUCTS, INITIAL_STOCK, HOT_THRESHOLD, 0, HOT_WINDOW);
+std::atomic<int> rejected_sells{ 0 };
+
+// Ubicación de los hilos (--pin=none|core|node, --cpus=0-3:8-11). Para
+// medir el tráfico entre nodos NUMA se guarda el nodo del último hilo que
+// tocó cada producto (protegido por su mutex).
+AffinityPlan affinity(Placement::None, CpuTopology::detect());
+int product_node[NUM_PRODUCTS];
+std::atomic<int> product_touches{ 0 };
+std::atomic<int> cross_node_touches{ 0 };
+std::atomic<int> pin_failures{ 0 };
+
+// Llamar con product_mutex[product_id] tomado
+void touch_product(int product_id) {
+    int node = affinity.current_node();
+    if (node >= 0 && product_node[product_id] >= 0) {
+        ++product_touches;
+        if (product_node[product_id] != node) ++cross_node_touches;
+    }
+    product_node[product_id] = node;
+}
+
 struct Operation {
     bool is_sell;      // true = vender, false = reabastecer
     int product_id;
@@ -34,6 +85,7 @@ void random_sleep(int max_ms = 10) {
 // Se restringe a un solo hilo por producto a la vez.
 void vender(int product_id, int quantity) {
     std::lock_guard<std::mutex> lock(product_mutex[product_id]);  // entrar a la sección crítica
+    touch_product(product_id);
 
     int current = stock[product_id];              // <-- sección crítica protegida
     random_sleep();
@@ -44,6 +96,7 @@ void vender(int product_id, int quantity) {
 
 void reabastecer(int product_id, int quantity) {
     std::lock_guard<std::mutex> lock(product_mutex[product_id]);
+    touch_product(product_id);
 
     int current = stock[product_id];
     random_sleep();
@@ -52,11 +105,83 @@ void reabastecer(int product_id, int quantity) {
     // mutex se libera automáticamente al salir de 'lock'
 }
 
+// Pedido de varias líneas sobre el inventario con mutex: se reservan todas
+// las líneas o ninguna (sin descuentos parciales). Los mutex se toman en
+// orden creciente de producto (ver normalize_order) para no caer en
+// deadlock con otro pedido. Siempre exige stock suficiente.
+bool place_order(std::span<const OrderLine> lines) {
+    return place_order_sorted(lines,
+        [](int id) -> std::mutex& { return product_mutex[id]; },
+        [](int id) {
+            touch_product(id);
+            return stock[id];
+        },
+        [](int id, int quantity) { stock[id] -= quantity; }) == OrderResult::Committed;
+}
+
+// ------- FUNCIONES SIN LOCKS -------
+
+// Misma operación sobre el inventario atómico: el descuento y la
+// comprobación del stock son un solo CAS, no hay sección crítica donde
+// dormir
+void vender_atomico(int product_id, int quantity) {
+    if (!atomic_stock.vender(product_id, quantity, non_negative)) ++rejected_sells;
+}
+
+void reabastecer_atomico(int product_id, int quantity) {
+    atomic_stock.reabastecer(product_id, quantity);
+}
+
+// ------- FUNCIONES CON PRODUCTOS CALIENTES -------
+
+// Mutex por producto mientras no haya contención; los productos donde los
+// hilos se acumulan pasan a contadores por núcleo
+void vender_combinado(int product_id, int quantity) {
+    if (!hot_stock.vender(product_id, quantity, non_negative)) ++rejected_sells;
+}
+
+void reabastecer_combinado(int product_id, int quantity) {
+    hot_stock.reabastecer(product_id, quantity);
+}
+
+int stock_actual(int product_id) {
+    switch (backend) {
+    case StockBackend::Atomic: return atomic_stock.stock(product_id);
+    case StockBackend::Hot:    return hot_stock.stock(product_id);
+    default:                   return stock[product_id];
+    }
+}
+
+// Aplica una operación con el backend elegido
+void execute_operation(const Operation& op) {
+    if (backend == StockBackend::Atomic) {
+        if (op.is_sell) vender_atomico(op.product_id, op.quantity);
+        else reabastecer_atomico(op.product_id, op.quantity);
+    }
+    else if (backend == StockBackend::Hot) {
+        if (op.is_sell) vender_combinado(op.product_id, op.quantity);
+        else reabastecer_combinado(op.product_id, op.quantity);
+    }
+    else if (op.is_sell) {
+        vender(op.product_id, op.quantity);
+    }
+    else {
+        reabastecer(op.product_id, op.quantity);
+    }
+}
+
+// Con --pool las corridas usan estos hilos (creados una vez en main) en
+// lugar de crear 20 threads cada una
+std::unique_ptr<WorkerPool<Operation>> pool;
+
 void run_single_simulation(int run_id) {
     // Inicializar stock
     for (int i = 0; i < NUM_PRODUCTS; ++i) {
         stock[i] = INITIAL_STOCK;
+        product_node[i] = -1;
     }
+    atomic_stock.reset(INITIAL_STOCK);
+    hot_stock.reset(INITIAL_STOCK, true);
 
     // Definir operaciones (igual que en la versión con problema)
     vector<Operation> ops(20);
@@ -85,41 +210,660 @@ void run_single_simulation(int run_id) {
     ops[18] = { false, 8, 40 };
     ops[19] = { false, 9, 20 };
 
-    // Crear 20 threads
-    vector<thread> threads;
-    threads.reserve(20);
-
-    for (int i = 0; i < 20; ++i) {
-        threads.emplace_back([i, &ops]() {
-            random_sleep();
-            if (ops[i].is_sell) {
-                vender(ops[i].product_id, ops[i].quantity);
-            }
-            else {
-                reabastecer(ops[i].product_id, ops[i].quantity);
-            }
-            });
+    if (pool) {
+        pool->submit(std::span<const Operation>(ops));
+        pool->wait();
     }
+    else {
+        // Crear 20 threads
+        vector<thread> threads;
+        threads.reserve(20);
+
+        for (int i = 0; i < 20; ++i) {
+            threads.emplace_back([i, &ops]() {
+                if (!affinity.apply(i)) ++pin_failures;
+                random_sleep();
+                execute_operation(ops[i]);
+                });
+        }
 
-    for (auto& t : threads) {
-        t.join();
+        for (auto& t : threads) {
+            t.join();
+        }
     }
 
     int expected0 = INITIAL_STOCK - 10 + 30;  // 120
     int expected5 = INITIAL_STOCK - 15 + 25;  // 110
 
-    bool ok0 = (stock[0] == expected0);
-    bool ok5 = (stock[5] == expected5);
+    bool ok0 = (stock_actual(0) == expected0);
+    bool ok5 = (stock_actual(5) == expected5);
     bool all_ok = ok0 && ok5;
 
     std::cout << "SIN RC #" << run_id << " -> "
-        << "Stock[0]=" << stock[0] << " (exp " << expected0 << "), "
-        << "Stock[5]=" << stock[5] << " (exp " << expected5 << ")"
+        << "Stock[0]=" << stock_actual(0) << " (exp " << expected0 << "), "
+        << "Stock[5]=" << stock_actual(5) << " (exp " << expected5 << ")"
         << "  => " << (all_ok ? "CORRECTO" : "INCORRECTO") << "\n";
 }
 
-int main() {
-    std::cout << "===== VERSION SIN RACE CONDITION (CON MUTEX) =====\n";
+// ------- BENCHMARK -------
+
+// Generador rápido por hilo (xorshift32) para no medir std::mt19937
+struct FastRng {
+    uint32_t x;
+    uint32_t next() {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x;
+    }
+};
+
+// Operaciones/s de 'threads' hilos con operaciones al azar (mitad ventas,
+// mitad reabastecimientos de 1 a 4 unidades) sobre los NUM_PRODUCTS
+// productos, sin pausas. Devuelve false en 'exact' si el stock final no
+// coincide con lo que hicieron los hilos.
+template <class Inventory>
+double measure_stock_ops(Inventory& inv, int threads, int ops_per_thread, bool guard, bool& exact) {
+    std::vector<long long> delta(threads, 0);
+    std::atomic<bool> go{ false };
+    vector<thread> workers;
+    workers.reserve(threads);
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            if (!affinity.apply(t)) ++pin_failures;
+            FastRng rng{ 2463534242u + 7919u * (uint32_t)t };
+            long long d = 0;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (int i = 0; i < ops_per_thread; ++i) {
+                uint32_t r = rng.next();
+                int product = (int)(r % NUM_PRODUCTS);
+                int quantity = 1 + (int)((r >> 8) & 3);
+                if (r & (1u << 12)) {
+                    if (inv.vender(product, quantity, guard)) d -= quantity;
+                }
+                else {
+                    inv.reabastecer(product, quantity);
+                    d += quantity;
+                }
+            }
+            delta[t] = d;
+            });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long long expected = (long long)NUM_PRODUCTS * INITIAL_STOCK, total = 0;
+    for (long long d : delta) expected += d;
+    for (int p = 0; p < NUM_PRODUCTS; ++p) total += inv.stock(p);
+    exact = total == expected;
+    return (double)threads * ops_per_thread / secs;
+}
+
+// Mutex por producto (la versión actual) contra el inventario atómico,
+// con los productos contiguos y cada uno en su línea de caché, de 1 a 64
+// hilos
+void benchmark_atomic() {
+    const int threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    const int TOTAL_OPS = 4000000;
+
+    std::cout << "===== BENCHMARK INVENTARIO (mutex vs atomico, " << NUM_PRODUCTS << " productos) =====\n";
+    std::cout << "Hilos\tMutex(Mops/s)\tAtomico_denso(Mops/s)\tAtomico_padding(Mops/s)\tPadding+guarda(Mops/s)\tExacto\n";
+
+    for (int n : threadCounts) {
+        int perThread = TOTAL_OPS / n;
+        bool ok[4];
+        MutexInventory mutexInv(NUM_PRODUCTS, INITIAL_STOCK);
+        DenseAtomicInventory dense(NUM_PRODUCTS, INITIAL_STOCK);
+        AtomicInventory padded(NUM_PRODUCTS, INITIAL_STOCK);
+        AtomicInventory guarded(NUM_PRODUCTS, INITIAL_STOCK);
+        double rate[4] = {
+            measure_stock_ops(mutexInv, n, perThread, false, ok[0]),
+            measure_stock_ops(dense, n, perThread, false, ok[1]),
+            measure_stock_ops(padded, n, perThread, false, ok[2]),
+            measure_stock_ops(guarded, n, perThread, true, ok[3]),
+        };
+
+        std::cout << n << "\t" << std::fixed << std::setprecision(2)
+            << rate[0] / 1e6 << "\t\t" << rate[1] / 1e6 << "\t\t\t"
+            << rate[2] / 1e6 << "\t\t\t" << rate[3] / 1e6 << "\t\t\t"
+            << (ok[0] && ok[1] && ok[2] && ok[3] ? "SI" : "NO") << "\n";
+    }
+    std::cout << "======================================================\n";
+}
+
+// Catálogo de 'skus' claves dispersas de 64 bits: inventario por shards
+// (sku_inventory.h) contra un std::unordered_map con un solo mutex.
+// Reporta memoria por SKU y operaciones/s de 1 a 64 hilos; las
+// operaciones eligen SKU al azar (mitad ventas, mitad reabastecimientos).
+void benchmark_skus(size_t skus) {
+    const int threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    const int TOTAL_OPS = 4000000;
+
+    // Multiplicar por una constante impar es biyectivo: claves únicas y
+    // repartidas por todo el rango
+    vector<uint64_t> keys(skus);
+    for (size_t i = 0; i < skus; ++i) keys[i] = (uint64_t)(i + 1) * 0x9E3779B97F4A7C15ull;
+
+    auto t0 = std::chrono::steady_clock::now();
+    ShardedInventory sharded(skus);
+    for (uint64_t k : keys) sharded.add_sku(k, INITIAL_STOCK);
+    double loadSharded = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    t0 = std::chrono::steady_clock::now();
+    std::unordered_map<uint64_t, int> map;
+    map.reserve(skus);
+    for (uint64_t k : keys) map[k] = INITIAL_STOCK;
+    double loadMap = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::mutex mapMutex;
+
+    // unordered_map: un puntero por bucket y un nodo por SKU (siguiente +
+    // par clave/valor, redondeado a 16 bytes como hace malloc)
+    size_t nodeBytes = (sizeof(void*) + sizeof(std::pair<const uint64_t, int>) + 15) / 16 * 16;
+    size_t mapBytes = map.bucket_count() * sizeof(void*) + map.size() * nodeBytes;
+
+    std::cout << "===== BENCHMARK INVENTARIO POR SKU (" << skus << " SKUs) =====\n";
+    std::cout << std::fixed << std::setprecision(1)
+        << "Shards (" << sharded.shards() << ", direccionamiento abierto): "
+        << (double)sharded.memory_bytes() / skus << " bytes/SKU, carga " << loadSharded << " s\n"
+        << "unordered_map + mutex global: ~" << (double)mapBytes / skus << " bytes/SKU (estimado), carga "
+        << loadMap << " s\n";
+    std::cout << "Hilos\tShards(Mops/s)\tunordered_map(Mops/s)\tExacto\n";
+
+    struct MapInventory {
+        std::unordered_map<uint64_t, int>& map;
+        std::mutex& mtx;
+        bool vender(uint64_t sku, int quantity) {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = map.find(sku);
+            if (it == map.end()) return false;
+            it->second -= quantity;
+            return true;
+        }
+        void reabastecer(uint64_t sku, int quantity) {
+            std::lock_guard<std::mutex> lock(mtx);
+            map[sku] += quantity;
+        }
+    } mapInv{ map, mapMutex };
+
+    long long expected = (long long)skus * INITIAL_STOCK;
+    for (int n : threadCounts) {
+        int perThread = TOTAL_OPS / n;
+        auto run = [&](auto& inv) {
+            std::vector<long long> delta(n, 0);
+            vector<thread> workers;
+            workers.reserve(n);
+            auto start = std::chrono::steady_clock::now();
+            for (int t = 0; t < n; ++t) {
+                workers.emplace_back([&, t]() {
+                    if (!affinity.apply(t)) ++pin_failures;
+                    FastRng rng{ 2463534242u + 7919u * (uint32_t)t };
+                    long long d = 0;
+                    for (int i = 0; i < perThread; ++i) {
+                        uint32_t r = rng.next();
+                        uint64_t sku = keys[(((uint64_t)r << 16) ^ rng.next()) % skus];
+                        int quantity = 1 + (int)(r & 3);
+                        if (r & 4) {
+                            if (inv.vender(sku, quantity)) d -= quantity;
+                        }
+                        else {
+                            inv.reabastecer(sku, quantity);
+                            d += quantity;
+                        }
+                    }
+                    delta[t] = d;
+                    });
+            }
+            for (auto& w : workers) w.join();
+            double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            for (long long d : delta) expected += d;
+            return (double)n * perThread / secs;
+        };
+
+        // Las dos estructuras reciben la misma secuencia de operaciones
+        long long before = expected;
+        double rateSharded = run(sharded);
+        bool exact = sharded.total_stock() == expected;
+        expected = before;
+        double rateMap = run(mapInv);
+        long long mapTotal = 0;
+        for (const auto& kv : map) mapTotal += kv.second;
+        exact = exact && mapTotal == expected;
+
+        std::cout << n << "\t" << std::setprecision(2) << rateSharded / 1e6 << "\t\t"
+            << rateMap / 1e6 << "\t\t\t" << (exact ? "SI" : "NO") << "\n";
+    }
+    std::cout << "======================================================\n";
+}
+
+// Pedidos todo-o-nada de 'lines' líneas sobre los primeros 'range'
+// productos: cuanto menor el rango y más líneas, más pedidos comparten
+// productos. Compara la toma ordenada de mutex contra la confirmación
+// optimista con versiones (que reintenta cada conflicto) y reporta
+// pedidos/s y tasa de aborto.
+void benchmark_orders() {
+    const int THREADS = 8;
+    const int ORDERS_PER_THREAD = 100000;
+    const int PRODUCTS = 100000;
+    const int lineCounts[] = { 1, 2, 4, 8, 16 };
+    const int ranges[] = { 100000, 1000, 100, 10 };
+    // Stock de sobra: los abortos que se miden son solo por concurrencia
+    const int STOCK = 1 << 30;
+
+    std::cout << "===== BENCHMARK PEDIDOS TODO-O-NADA (" << THREADS << " hilos) =====\n";
+    std::cout << "Lineas\tProductos\tOrdenado(Kped/s)\tOptimista(Kped/s)\tAbortos(%)\tExacto\n";
+
+    for (int lines : lineCounts) {
+        for (int range : ranges) {
+            auto run = [&](OrderInventory& inv, bool optimistic, long long& conflicts) {
+                std::vector<long long> sold(THREADS, 0), aborted(THREADS, 0);
+                vector<thread> workers;
+                workers.reserve(THREADS);
+                auto start = std::chrono::steady_clock::now();
+                for (int t = 0; t < THREADS; ++t) {
+                    workers.emplace_back([&, t]() {
+                        if (!affinity.apply(t)) ++pin_failures;
+                        FastRng rng{ 2463534242u + 7919u * (uint32_t)t };
+                        std::vector<OrderLine> order(lines);
+                        for (int i = 0; i < ORDERS_PER_THREAD; ++i) {
+                            int units = 0;
+                            for (OrderLine& l : order) {
+                                uint32_t r = rng.next();
+                                l = { (int)(r % (uint32_t)range), 1 + (int)((r >> 24) & 3) };
+                                units += l.quantity;
+                            }
+                            OrderResult res;
+                            if (!optimistic) res = inv.place_order(order);
+                            else {
+                                while ((res = inv.place_order_optimistic(order)) == OrderResult::Conflict) ++aborted[t];
+                            }
+                            if (res == OrderResult::Committed) sold[t] += units;
+                        }
+                        });
+                }
+                for (auto& w : workers) w.join();
+                double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                long long expected = (long long)range * STOCK, total = 0;
+                conflicts = 0;
+                for (int t = 0; t < THREADS; ++t) {
+                    expected -= sold[t];
+                    conflicts += aborted[t];
+                }
+                for (int p = 0; p < range; ++p) total += inv.stock(p);
+                return std::make_pair((double)THREADS * ORDERS_PER_THREAD / secs, total == expected);
+            };
+
+            OrderInventory locked(PRODUCTS, STOCK), optimistic(PRODUCTS, STOCK);
+            long long unused = 0, conflicts = 0;
+            auto [rateLocked, okLocked] = run(locked, false, unused);
+            auto [rateOpt, okOpt] = run(optimistic, true, conflicts);
+            double attempts = (double)THREADS * ORDERS_PER_THREAD + conflicts;
+
+            std::cout << lines << "\t" << range << "\t\t" << std::fixed << std::setprecision(1)
+                << rateLocked / 1e3 << "\t\t\t" << rateOpt / 1e3 << "\t\t\t"
+                << std::setprecision(3) << 100.0 * conflicts / attempts << "\t\t"
+                << (okLocked && okOpt ? "SI" : "NO") << "\n";
+        }
+    }
+    std::cout << "======================================================\n";
+}
+
+// --check-orders: comprueba el todo o nada de los pedidos y termina con
+// código 1 si algo falla. Casos: un pedido cuya última línea no alcanza no
+// descuenta ninguna, las líneas repetidas se suman, las dos estrategias de
+// OrderInventory hacen lo mismo y pedidos concurrentes con los productos en
+// orden inverso no se bloquean ni dejan stock negativo.
+bool check_orders() {
+    bool ok = true;
+    auto expect = [&ok](bool cond, const std::string& what) {
+        if (!cond) {
+            std::cerr << "FALLA: " << what << "\n";
+            ok = false;
+        }
+    };
+    auto unchanged = [](auto stock_of, int products) {
+        for (int p = 0; p < products; ++p) {
+            if (stock_of(p) != INITIAL_STOCK) return false;
+        }
+        return true;
+    };
+
+    OrderLine partial[] = { { 0, 10 }, { 1, 10 }, { 2, INITIAL_STOCK + 1 } };
+    OrderLine repeated[] = { { 2, 10 }, { 0, 10 }, { 2, 5 } };
+
+    // Inventario global
+    for (int i = 0; i < NUM_PRODUCTS; ++i) {
+        stock[i] = INITIAL_STOCK;
+        product_node[i] = -1;
+    }
+    expect(!place_order(partial), "global: pedido sin stock suficiente aceptado");
+    expect(unchanged([](int p) { return stock[p]; }, NUM_PRODUCTS), "global: pedido rechazado descontó stock");
+    expect(place_order(repeated), "global: pedido con producto repetido rechazado");
+    expect(stock[0] == INITIAL_STOCK - 10 && stock[2] == INITIAL_STOCK - 15, "global: líneas repetidas mal sumadas");
+
+    // OrderInventory, con las dos estrategias
+    for (bool optimistic : { false, true }) {
+        std::string name = optimistic ? "optimista: " : "ordenado: ";
+        OrderInventory inv(NUM_PRODUCTS, INITIAL_STOCK);
+        auto place = [&](std::span<const OrderLine> lines) {
+            return optimistic ? inv.place_order_optimistic(lines) : inv.place_order(lines);
+        };
+        expect(place(partial) == OrderResult::OutOfStock, name + "pedido sin stock suficiente aceptado");
+        expect(unchanged([&inv](int p) { return inv.stock(p); }, NUM_PRODUCTS), name + "pedido rechazado descontó stock");
+        expect(place(repeated) == OrderResult::Committed, name + "pedido con producto repetido rechazado");
+        expect(inv.stock(0) == INITIAL_STOCK - 10 && inv.stock(2) == INITIAL_STOCK - 15, name + "líneas repetidas mal sumadas");
+    }
+
+    // Concurrencia: la mitad de los hilos pide 0,1,2,3 y la otra 3,2,1,0
+    const int THREADS = 8, ORDERS = 20000, PRODUCTS = 4;
+    OrderInventory inv(PRODUCTS, INITIAL_STOCK);
+    std::vector<long long> sold(THREADS, 0), restocked(THREADS, 0);
+    vector<thread> workers;
+    for (int t = 0; t < THREADS; ++t) {
+        workers.emplace_back([&, t]() {
+            for (int i = 0; i < ORDERS; ++i) {
+                OrderLine lines[PRODUCTS];
+                for (int k = 0; k < PRODUCTS; ++k) lines[k] = { (t & 1) ? PRODUCTS - 1 - k : k, 1 };
+                OrderResult r = (t & 2) ? inv.place_order_optimistic(lines) : inv.place_order(lines);
+                if (r == OrderResult::Committed) sold[t] += PRODUCTS;
+                if (i % 3 == 0) {
+                    for (int p = 0; p < PRODUCTS; ++p) inv.reabastecer(p, 1);
+                    restocked[t] += PRODUCTS;
+                }
+            }
+            });
+    }
+    for (auto& w : workers) w.join();
+    long long expected = (long long)PRODUCTS * INITIAL_STOCK, total = 0;
+    for (int t = 0; t < THREADS; ++t) expected += restocked[t] - sold[t];
+    for (int p = 0; p < PRODUCTS; ++p) {
+        expect(inv.stock(p) >= 0, "concurrente: stock negativo en el producto " + std::to_string(p));
+        total += inv.stock(p);
+    }
+    expect(total == expected, "concurrente: el stock final no coincide con los pedidos confirmados");
+
+    std::cout << "Pedidos todo-o-nada: " << (ok ? "OK" : "CON FALLAS") << "\n";
+    return ok;
+}
+
+// Índices de productos con distribución Zipf de parámetro 's' (s = 0 es
+// uniforme): el producto k se elige con probabilidad proporcional a
+// 1/(k+1)^s. La tabla acumulada se busca con búsqueda binaria.
+struct ZipfTable {
+    std::vector<uint32_t> cdf;
+
+    ZipfTable(int products, double s) : cdf(products) {
+        std::vector<double> w(products);
+        double sum = 0;
+        for (int k = 0; k < products; ++k) sum += w[k] = 1.0 / std::pow(k + 1.0, s);
+        double acc = 0;
+        for (int k = 0; k < products; ++k) {
+            acc += w[k];
+            cdf[k] = (uint32_t)std::min(acc / sum * 4294967295.0, 4294967295.0);
+        }
+        cdf[products - 1] = 0xFFFFFFFFu;
+    }
+
+    int pick(uint32_t r) const { return (int)(std::lower_bound(cdf.begin(), cdf.end(), r) - cdf.begin()); }
+};
+
+// Ventas y reabastecimientos con guarda sobre productos elegidos con
+// distribución Zipf: mutex por producto contra HotInventory con detección
+// automática y con todos los productos en modo combinado desde el inicio.
+// Con s alto casi todas las operaciones caen en unos pocos productos.
+void benchmark_hot() {
+    const int PRODUCTS = 1000;
+    const int threadCounts[] = { 1, 4, 16, 64 };
+    const double skews[] = { 0.0, 0.99, 1.2, 1.5 };
+    const int TOTAL_OPS = 4000000;
+
+    std::cout << "===== BENCHMARK PRODUCTOS CALIENTES (" << PRODUCTS << " productos, Zipf, con guarda) =====\n";
+    std::cout << "Zipf_s\tHilos\tMutex(Mops/s)\tDeteccion(Mops/s)\tCombinado(Mops/s)\tCalientes\tExacto\n";
+
+    for (double s : skews) {
+        ZipfTable zipf(PRODUCTS, s);
+        for (int n : threadCounts) {
+            int perThread = TOTAL_OPS / n;
+            auto run = [&](auto& inv, bool& exact) {
+                std::vector<long long> delta(n, 0);
+                std::atomic<bool> go{ false };
+                vector<thread> workers;
+                workers.reserve(n);
+                for (int t = 0; t < n; ++t) {
+                    workers.emplace_back([&, t]() {
+                        if (!affinity.apply(t)) ++pin_failures;
+                        FastRng rng{ 2463534242u + 7919u * (uint32_t)t };
+                        long long d = 0;
+                        while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                        for (int i = 0; i < perThread; ++i) {
+                            int product = zipf.pick(rng.next());
+                            uint32_t r = rng.next();
+                            int quantity = 1 + (int)(r & 3);
+                            if (r & 4) {
+                                if (inv.vender(product, quantity, true)) d -= quantity;
+                            }
+                            else {
+                                inv.reabastecer(product, quantity);
+                                d += quantity;
+                            }
+                        }
+                        delta[t] = d;
+                        });
+                }
+                auto start = std::chrono::steady_clock::now();
+                go.store(true, std::memory_order_release);
+                for (auto& w : workers) w.join();
+                double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                long long expected = (long long)PRODUCTS * INITIAL_STOCK, total = 0;
+                bool negative = false;
+                for (long long d : delta) expected += d;
+                for (int p = 0; p < PRODUCTS; ++p) {
+                    int st = inv.stock(p);
+                    negative = negative || st < 0;
+                    total += st;
+                }
+                exact = total == expected && !negative;
+                return (double)n * perThread / secs;
+            };
+
+            bool ok[3];
+            MutexInventory mutexInv(PRODUCTS, INITIAL_STOCK);
+            HotInventory detecting(PRODUCTS, INITIAL_STOCK);
+            HotInventory combined(PRODUCTS, INITIAL_STOCK, 0);
+            double rate[3] = { run(mutexInv, ok[0]), run(detecting, ok[1]), run(combined, ok[2]) };
+
+            std::cout << std::setprecision(2) << s << "\t" << n << "\t" << std::fixed
+                << rate[0] / 1e6 << "\t\t" << rate[1] / 1e6 << "\t\t\t" << rate[2] / 1e6 << "\t\t\t"
+                << detecting.hot_products() << "\t\t" << (ok[0] && ok[1] && ok[2] ? "SI" : "NO") << "\n";
+            std::cout.unsetf(std::ios::fixed);
+        }
+    }
+    std::cout << "======================================================\n";
+}
+
+// Costo de crear hilos contra el pool persistente: RUNS corridas de
+// 'opsPerRun' operaciones al azar (sin pausas) sobre un inventario con
+// mutex por producto. "Hilo por operación" es lo que hace
+// run_single_simulation: un std::thread por operación, creado y unido en
+// cada corrida. Reporta el costo de arrancar el pool y operaciones/s.
+void benchmark_pool() {
+    const int RUNS = 10;
+    const int opsPerRunList[] = { 20, 1000, 100000, 1000000 };
+    const int THREAD_PER_OP_LIMIT = 1000;  // más hilos por corrida no tiene sentido
+    const int WORKERS = (int)std::max(4u, std::thread::hardware_concurrency());
+
+    MutexInventory inv(NUM_PRODUCTS, INITIAL_STOCK);
+    auto apply_op = [&inv](const Operation& op) {
+        if (op.is_sell) inv.vender(op.product_id, op.quantity);
+        else inv.reabastecer(op.product_id, op.quantity);
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::atomic<int> started{ 0 };
+    WorkerPool<Operation> benchPool(WORKERS, apply_op, [&started](int i) {
+        if (!affinity.apply(i)) ++pin_failures;
+        ++started;
+        });
+    while (started.load() < WORKERS) std::this_thread::yield();
+    double startup = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "===== BENCHMARK POOL DE HILOS (" << RUNS << " corridas, " << WORKERS << " hilos en el pool) =====\n";
+    std::cout << std::fixed << std::setprecision(1) << "Arranque del pool: " << startup * 1e6 << " us ("
+        << startup * 1e6 / WORKERS << " us por hilo)\n";
+    std::cout << "Ops/corrida\tHilo_por_op(Kops/s)\tPool(Kops/s)\tExacto\n";
+
+    FastRng rng{ 2463534242u };
+    for (int opsPerRun : opsPerRunList) {
+        std::vector<std::vector<Operation>> runs(RUNS, std::vector<Operation>(opsPerRun));
+        long long delta = 0;
+        for (auto& ops : runs) {
+            for (Operation& op : ops) {
+                uint32_t r = rng.next();
+                op = { (r & 1) != 0, (int)((r >> 1) % NUM_PRODUCTS), 1 + (int)((r >> 8) & 3) };
+                delta += op.is_sell ? -op.quantity : op.quantity;
+            }
+        }
+        auto total_stock = [&inv]() {
+            long long total = 0;
+            for (int p = 0; p < NUM_PRODUCTS; ++p) total += inv.stock(p);
+            return total;
+        };
+
+        double perOpRate = 0;
+        bool exact = true;
+        if (opsPerRun <= THREAD_PER_OP_LIMIT) {
+            long long before = total_stock();
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& ops : runs) {
+                vector<thread> threads;
+                threads.reserve(ops.size());
+                for (size_t i = 0; i < ops.size(); ++i) {
+                    threads.emplace_back([i, &ops, &apply_op]() {
+                        if (!affinity.apply((int)i)) ++pin_failures;
+                        apply_op(ops[i]);
+                        });
+                }
+                for (auto& t : threads) t.join();
+            }
+            double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            perOpRate = (double)RUNS * opsPerRun / secs;
+            exact = total_stock() == before + delta;
+        }
+
+        long long before = total_stock();
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& ops : runs) {
+            benchPool.submit(std::span<const Operation>(ops));
+            benchPool.wait();
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double poolRate = (double)RUNS * opsPerRun / secs;
+        exact = exact && total_stock() == before + delta;
+
+        std::cout << opsPerRun << "\t\t";
+        if (opsPerRun <= THREAD_PER_OP_LIMIT) std::cout << perOpRate / 1e3 << "\t\t\t";
+        else std::cout << "-\t\t\t";
+        std::cout << poolRate / 1e3 << "\t\t" << (exact ? "SI" : "NO") << "\n";
+    }
+    std::cout << "======================================================\n";
+}
+
+int main(int argc, char** argv) {
+    Placement placement = Placement::None;
+    vector<int> cpus;
+    bool bench = false;
+    bool benchSkus = false;
+    bool benchOrders = false;
+    bool checkOrders = false;
+    bool benchHot = false;
+    bool benchPool = false;
+    bool usePool = false;
+    size_t skus = 5000000;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        try {
+            if (arg.rfind("--pin=", 0) == 0)       placement = parse_placement(arg.substr(6));
+            else if (arg.rfind("--cpus=", 0) == 0) cpus = parse_cpu_list(arg.substr(7), ':');
+            else if (arg == "--backend=mutex")  backend = StockBackend::Mutex;
+            else if (arg == "--backend=atomic") backend = StockBackend::Atomic;
+            else if (arg == "--backend=hot")    backend = StockBackend::Hot;
+            else if (arg == "--guard")          non_negative = true;
+            else if (arg == "--bench-atomic")   bench = true;
+            else if (arg == "--bench-skus")     benchSkus = true;
+            else if (arg.rfind("--skus=", 0) == 0) skus = (size_t)std::stoull(arg.substr(7));
+            else if (arg == "--bench-orders")   benchOrders = true;
+            else if (arg == "--check-orders")   checkOrders = true;
+            else if (arg == "--bench-hot")      benchHot = true;
+            else if (arg == "--pool")           usePool = true;
+            else if (arg == "--bench-pool")     benchPool = true;
+            else throw invalid_argument("opcion desconocida: " + arg);
+        }
+        catch (const logic_error& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    // La topología se lee una sola vez, con las opciones ya leídas
+    try {
+        affinity = AffinityPlan(placement, CpuTopology::detect(cpus));
+    }
+    catch (const logic_error& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (non_negative && backend == StockBackend::Mutex) {
+        std::cerr << "Error: --guard requiere --backend=atomic o --backend=hot\n";
+        return 1;
+    }
+    if (bench) {
+        benchmark_atomic();
+        return 0;
+    }
+    if (benchSkus) {
+        if (skus == 0) {
+            std::cerr << "Error: --skus debe ser mayor que 0\n";
+            return 1;
+        }
+        benchmark_skus(skus);
+        return 0;
+    }
+    if (checkOrders) {
+        return check_orders() ? 0 : 1;
+    }
+    if (benchOrders) {
+        benchmark_orders();
+        return 0;
+    }
+    if (benchHot) {
+        benchmark_hot();
+        return 0;
+    }
+    if (benchPool) {
+        benchmark_pool();
+        return 0;
+    }
+
+    std::cout << "===== VERSION SIN RACE CONDITION ("
+        << (backend == StockBackend::Atomic ? "ATOMICA, SIN LOCKS"
+            : backend == StockBackend::Hot ? "CON MUTEX Y PRODUCTOS CALIENTES" : "CON MUTEX") << ") =====\n";
+    auto start = std::chrono::steady_clock::now();
+
+    // Los 20 hilos del pool toman una operación por vez, igual que los 20
+    // threads de cada corrida
+    if (usePool) {
+        pool = std::make_unique<WorkerPool<Operation>>(20,
+            [](const Operation& op) {
+                random_sleep();
+                execute_operation(op);
+            },
+            [](int i) { if (!affinity.apply(i)) ++pin_failures; },
+            1);
+    }
 
     // No es necesario inicializar nada para los mutex (a diferencia de los semáforos)
 
@@ -128,7 +872,47 @@ int main() {
         run_single_simulation(i);
     }
 
-    // No es necesario destruir nada (los mutex se manejan automáticamente)
+    // No es necesario destruir nada (los mutex se manejan automáticamente);
+    // el pool sí: espera a sus hilos
+    pool.reset();
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Tiempo total: " << secs << " s\n";
+
+    // Las corridas duermen en cada operación, así que su tiempo no muestra
+    // el efecto de la afinidad: el throughput se mide aparte, sin pausas,
+    // con 20 hilos ubicados igual y el inventario del backend elegido
+    const int THROUGHPUT_OPS = 200000;
+    bool exact = false;
+    double rate;
+    if (backend == StockBackend::Atomic) {
+        AtomicInventory inv(NUM_PRODUCTS, INITIAL_STOCK);
+        rate = measure_stock_ops(inv, 20, THROUGHPUT_OPS, non_negative, exact);
+    }
+    else if (backend == StockBackend::Hot) {
+        HotInventory inv(NUM_PRODUCTS, INITIAL_STOCK);
+        rate = measure_stock_ops(inv, 20, THROUGHPUT_OPS, non_negative, exact);
+    }
+    else {
+        MutexInventory inv(NUM_PRODUCTS, INITIAL_STOCK);
+        rate = measure_stock_ops(inv, 20, THROUGHPUT_OPS, false, exact);
+    }
+    std::cout << "Operaciones/s sin pausas (20 hilos): " << std::fixed << std::setprecision(0) << rate
+        << (exact ? "" : " (stock final inexacto)") << "\n";
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << "Afinidad: " << (placement == Placement::None ? "sin fijar" : placement == Placement::Core ? "nucleo" : "nodo")
+        << " (" << affinity.topology().describe() << ")"
+        << (pin_failures > 0 ? ", hilos sin fijar: " + std::to_string(pin_failures.load()) : "") << "\n";
+    if (non_negative) std::cout << "Ventas rechazadas por falta de stock: " << rejected_sells.load() << "\n";
+    // El nodo de cada producto solo se registra bajo product_mutex, es decir,
+    // con --backend=mutex
+    if (backend == StockBackend::Mutex) {
+        std::cout << "Productos que cambiaron de nodo entre operaciones: " << cross_node_touches.load()
+            << " / " << product_touches.load() << "\n";
+    }
+    if (backend == StockBackend::Hot) {
+        std::cout << "Productos calientes: " << hot_stock.hot_products() << " / " << NUM_PRODUCTS << "\n";
+    }
 
     std::cout << "======================================================\n";
     return 0;
@@ -0,0 +1,189 @@
+// sku_inventory.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+// Inventario por SKU para catálogos grandes y dispersos (decenas de
+// millones de claves de 64 bits), con la misma semántica de vender /
+// reabastecer que el inventario de 10 productos.
+//
+// Las claves se reparten en 'shards' (potencia de 2) según los bits altos
+// de su hash; cada shard tiene su propio mutex (lock striping) y su propia
+// tabla de direccionamiento abierto con sondeo lineal. Cada entrada es
+// {clave, stock} en 16 bytes, así el sondeo lee clave y stock de la misma
+// línea de caché (4 entradas por línea) sin seguir punteros. Los shards
+// están alineados a 64 bytes para que dos mutex no compartan línea.
+//
+// La tabla de un shard crece al doble al superar 3/4 de ocupación (bajo su
+// lock; los demás shards siguen atendiendo). Los SKU no se borran, así que
+// no hacen falta marcas de borrado. El valor ~0 está reservado.
+class ShardedInventory {
+public:
+    static constexpr std::uint64_t EMPTY = ~std::uint64_t(0);
+
+    // 'expected_skus' dimensiona las tablas para no crecer al cargar el
+    // catálogo; 'shards' se redondea a potencia de 2
+    explicit ShardedInventory(std::size_t expected_skus, std::size_t shards = 64) {
+        std::size_t n = 1;
+        while (n < shards) n <<= 1;
+        shard_bits_ = 0;
+        while ((std::size_t(1) << shard_bits_) < n) ++shard_bits_;
+        shards_ = std::make_unique<Shard[]>(n);
+        num_shards_ = n;
+
+        std::size_t perShard = expected_skus / n + 1;
+        std::size_t cap = 16;
+        while (cap * 3 / 4 < perShard) cap <<= 1;
+        for (std::size_t s = 0; s < n; ++s) shards_[s].table.assign(cap, Entry{ EMPTY, 0, 0 });
+    }
+
+    // Da de alta el SKU con 'stock' unidades (o fija su stock si ya existe)
+    void add_sku(std::uint64_t sku, int stock) {
+        check(sku);
+        std::uint64_t h = hash(sku);
+        Shard& s = shard_for(h);
+        std::lock_guard<std::mutex> lock(s.mtx);
+        find_or_insert(s, sku, h).stock = stock;
+    }
+
+    // false si el SKU no existe o, con non_negative, si no alcanza el stock
+    bool vender(std::uint64_t sku, int quantity, bool non_negative = false) {
+        std::uint64_t h = hash(sku);
+        Shard& s = shard_for(h);
+        std::lock_guard<std::mutex> lock(s.mtx);
+        Entry* e = find(s, sku, h);
+        if (!e || (non_negative && e->stock < quantity)) return false;
+        e->stock -= quantity;
+        return true;
+    }
+
+    // Un SKU que no existía se da de alta con 'quantity' unidades
+    void reabastecer(std::uint64_t sku, int quantity) {
+        check(sku);
+        std::uint64_t h = hash(sku);
+        Shard& s = shard_for(h);
+        std::lock_guard<std::mutex> lock(s.mtx);
+        find_or_insert(s, sku, h).stock += quantity;
+    }
+
+    std::optional<int> stock(std::uint64_t sku) {
+        std::uint64_t h = hash(sku);
+        Shard& s = shard_for(h);
+        std::lock_guard<std::mutex> lock(s.mtx);
+        Entry* e = find(s, sku, h);
+        if (!e) return std::nullopt;
+        return e->stock;
+    }
+
+    std::size_t size() {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < num_shards_; ++i) {
+            std::lock_guard<std::mutex> lock(shards_[i].mtx);
+            n += shards_[i].size;
+        }
+        return n;
+    }
+
+    // Memoria de las tablas y de los shards (sin el objeto en sí)
+    std::size_t memory_bytes() {
+        std::size_t bytes = num_shards_ * sizeof(Shard);
+        for (std::size_t i = 0; i < num_shards_; ++i) {
+            std::lock_guard<std::mutex> lock(shards_[i].mtx);
+            bytes += shards_[i].table.capacity() * sizeof(Entry);
+        }
+        return bytes;
+    }
+
+    // Suma del stock de todos los SKU (con cada shard bloqueado por turno)
+    long long total_stock() {
+        long long total = 0;
+        for (std::size_t i = 0; i < num_shards_; ++i) {
+            std::lock_guard<std::mutex> lock(shards_[i].mtx);
+            for (const Entry& e : shards_[i].table) {
+                if (e.key != EMPTY) total += e.stock;
+            }
+        }
+        return total;
+    }
+
+    std::size_t shards() const { return num_shards_; }
+
+private:
+    struct Entry {
+        std::uint64_t key;
+        std::int32_t stock;
+        std::int32_t pad;
+    };
+    static_assert(sizeof(Entry) == 16, "entrada de 16 bytes");
+
+    struct alignas(64) Shard {
+        std::mutex mtx;
+        std::vector<Entry> table;
+        std::size_t size = 0;
+    };
+
+    // Finalizador de splitmix64: los SKU consecutivos quedan dispersos
+    static std::uint64_t hash(std::uint64_t x) {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    static void check(std::uint64_t sku) {
+        if (sku == EMPTY) throw std::invalid_argument("SKU reservado");
+    }
+
+    // Bits altos para el shard, bajos para la posición en su tabla
+    Shard& shard_for(std::uint64_t h) {
+        return shards_[shard_bits_ == 0 ? 0 : (std::size_t)(h >> (64 - shard_bits_))];
+    }
+
+    // nullptr también para EMPTY, que si no coincidiría con la primera
+    // posición libre
+    static Entry* find(Shard& s, std::uint64_t sku, std::uint64_t h) {
+        if (sku == EMPTY) return nullptr;
+        std::size_t mask = s.table.size() - 1;
+        for (std::size_t i = (std::size_t)h & mask;; i = (i + 1) & mask) {
+            Entry& e = s.table[i];
+            if (e.key == sku) return &e;
+            if (e.key == EMPTY) return nullptr;
+        }
+    }
+
+    // Busca primero: la tabla solo crece si hay que insertar y la
+    // inserción pasaría de 3/4 de ocupación
+    Entry& find_or_insert(Shard& s, std::uint64_t sku, std::uint64_t h) {
+        if (Entry* e = find(s, sku, h)) return *e;
+        if ((s.size + 1) * 4 > s.table.size() * 3) grow(s);
+        std::size_t mask = s.table.size() - 1;
+        std::size_t i = (std::size_t)h & mask;
+        while (s.table[i].key != EMPTY) i = (i + 1) & mask;
+        Entry& e = s.table[i];
+        e.key = sku;
+        e.stock = 0;
+        ++s.size;
+        return e;
+    }
+
+    static void grow(Shard& s) {
+        std::vector<Entry> old(s.table.size() * 2, Entry{ EMPTY, 0, 0 });
+        old.swap(s.table);
+        std::size_t mask = s.table.size() - 1;
+        for (const Entry& e : old) {
+            if (e.key == EMPTY) continue;
+            std::size_t i = (std::size_t)hash(e.key) & mask;
+            while (s.table[i].key != EMPTY) i = (i + 1) & mask;
+            s.table[i] = e;
+        }
+    }
+
+    std::unique_ptr<Shard[]> shards_;
+    std::size_t num_shards_ = 0;
+    unsigned shard_bits_ = 0;
+};
@@ -0,0 +1,109 @@
+// worker_pool.h
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Pool de hilos persistente con una cola de tareas: los hilos se crean una
+// sola vez y cada corrida solo encola sus operaciones y espera con wait().
+//
+// Cada hilo saca hasta 'batch' tareas por vez de la cola (un lock cada
+// 'batch' tareas, no uno por tarea) y llama a 'handler' con cada una. Con
+// tareas largas conviene batch = 1 para que se repartan entre todos los
+// hilos. 'on_start' se ejecuta una vez en cada hilo al arrancar (por
+// ejemplo, para fijar su afinidad) con el índice del hilo.
+template <class Task>
+class WorkerPool {
+public:
+    using Handler = std::function<void(const Task&)>;
+
+    WorkerPool(int workers, Handler handler, std::function<void(int)> on_start = {}, std::size_t batch = 64)
+        : handler_(std::move(handler)), batch_(std::max<std::size_t>(batch, 1))
+    {
+        threads_.reserve(workers);
+        for (int i = 0; i < workers; ++i) {
+            threads_.emplace_back([this, i, on_start]() {
+                if (on_start) on_start(i);
+                loop();
+                });
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Termina las tareas pendientes y espera a los hilos
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    int workers() const { return (int)threads_.size(); }
+
+    void submit(const Task& task) {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            queue_.push_back(task);
+            ++pending_;
+        }
+        work_cv_.notify_one();
+    }
+
+    void submit(std::span<const Task> tasks) {
+        if (tasks.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            queue_.insert(queue_.end(), tasks.begin(), tasks.end());
+            pending_ += tasks.size();
+        }
+        work_cv_.notify_all();
+    }
+
+    // Bloquea hasta que todas las tareas encoladas terminaron
+    void wait() {
+        std::unique_lock<std::mutex> lock(mtx_);
+        idle_cv_.wait(lock, [this]() { return pending_ == 0; });
+    }
+
+private:
+    void loop() {
+        std::vector<Task> batch;
+        batch.reserve(batch_);
+        std::unique_lock<std::mutex> lock(mtx_);
+        for (;;) {
+            work_cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) return;  // stop_ y nada pendiente
+
+            std::size_t n = std::min(batch_, queue_.size());
+            batch.assign(queue_.begin(), queue_.begin() + n);
+            queue_.erase(queue_.begin(), queue_.begin() + n);
+            lock.unlock();
+
+            for (const Task& t : batch) handler_(t);
+
+            lock.lock();
+            pending_ -= n;
+            if (pending_ == 0) idle_cv_.notify_all();
+        }
+    }
+
+    Handler handler_;
+    std::size_t batch_;
+    std::mutex mtx_;
+    std::condition_variable work_cv_;
+    std::condition_variable idle_cv_;
+    std::deque<Task> queue_;
+    std::size_t pending_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
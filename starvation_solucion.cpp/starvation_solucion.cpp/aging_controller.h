@@ -0,0 +1,116 @@
+// aging_controller.h
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "task.h"
+
+// Controlador que ajusta aging_interval_ms según la espera observada.
+//
+// Junta las esperas de cada clase durante una ventana de period_ms y al
+// cerrarla compara el p90 de cada clase con su objetivo. Una clase con
+// menos de min_samples esperas no opina (cuenta como en el objetivo) y
+// sus muestras pasan a la ventana siguiente.
+//   r_alta = max(p90_A / objetivo_A, p90_M / objetivo_M)
+//   r_baja = p90_B / objetivo_B
+// Acelerar el aging solo beneficia a B (M también pierde contra las B
+// envejecidas). Si alguna clase se pasó de su objetivo, el intervalo se
+// multiplica por (r_alta / r_baja)^gain, acotado a [0.5, 2] por ventana
+// y a [min_interval_ms, max_interval_ms]: si B va peor que A y M el aging
+// se acelera (intervalo menor); si las que se atrasan son A o M, se frena.
+// Con todas las clases dentro del objetivo el intervalo no cambia.
+//
+// No es thread-safe: la simulación lo usa con mtx_ tomado.
+class AgingController {
+public:
+    struct Params {
+        std::array<int, NUM_CLASSES> target_ms{ 200, 600, 1200 }; // objetivo de espera p90
+        int period_ms = 250;            // ventana de observación
+        std::size_t min_samples = 5;    // esperas por clase para opinar
+        double min_interval_ms = 10.0;
+        double max_interval_ms = 5000.0;
+        double gain = 0.5;
+    };
+
+    AgingController(double initial_interval_ms, const Params& p)
+        : params_(p) {
+        reset(initial_interval_ms);
+    }
+
+    void reset(double initial_interval_ms) {
+        interval_ms_ = std::clamp(initial_interval_ms, params_.min_interval_ms, params_.max_interval_ms);
+        min_seen_ = max_seen_ = interval_ms_;
+        adjustments_ = 0;
+        started_ = false;
+        for (auto& s : samples_) s.clear();
+    }
+
+    // Espera (us) de una tarea que acaba de salir de la cola
+    void record(char type, long long wait_us) {
+        samples_[class_index(type)].push_back(wait_us);
+    }
+
+    // Cierra la ventana si ya pasó period_ms desde la anterior. Devuelve
+    // true si cambió el intervalo.
+    bool update(std::chrono::steady_clock::time_point now) {
+        if (!started_) {
+            window_start_ = now;
+            started_ = true;
+            return false;
+        }
+        if (now - window_start_ < std::chrono::milliseconds(params_.period_ms)) return false;
+        window_start_ = now;
+
+        double ratio[NUM_CLASSES];
+        for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+            if (samples_[c].size() < params_.min_samples) {
+                ratio[c] = 1.0;
+                continue;
+            }
+            ratio[c] = p90_ms(samples_[c]) / std::max(params_.target_ms[c], 1);
+            samples_[c].clear();
+        }
+
+        double high = std::max(ratio[0], ratio[1]);
+        double low = ratio[2];
+        if (high <= 1.0 && low <= 1.0) return false;
+
+        double factor = std::clamp(std::pow(high / low, params_.gain), 0.5, 2.0);
+        double next = std::clamp(interval_ms_ * factor, params_.min_interval_ms, params_.max_interval_ms);
+        if (next == interval_ms_) return false;
+
+        interval_ms_ = next;
+        min_seen_ = std::min(min_seen_, next);
+        max_seen_ = std::max(max_seen_, next);
+        ++adjustments_;
+        return true;
+    }
+
+    double interval_ms() const { return interval_ms_; }
+    double min_interval_seen() const { return min_seen_; }
+    double max_interval_seen() const { return max_seen_; }
+    long long adjustments() const { return adjustments_; }
+    const Params& params() const { return params_; }
+
+private:
+    // p90 en ms de las esperas de la ventana (0 si no hubo tareas)
+    static double p90_ms(std::vector<long long>& v) {
+        if (v.empty()) return 0;
+        auto k = v.begin() + (std::ptrdiff_t)((v.size() - 1) * 9 / 10);
+        std::nth_element(v.begin(), k, v.end());
+        return *k / 1000.0;
+    }
+
+    Params params_;
+    double interval_ms_ = 0;
+    double min_seen_ = 0;
+    double max_seen_ = 0;
+    long long adjustments_ = 0;
+    bool started_ = false;
+    std::chrono::steady_clock::time_point window_start_;
+    std::vector<long long> samples_[NUM_CLASSES];
+};
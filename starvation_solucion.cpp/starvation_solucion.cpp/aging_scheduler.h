@@ -0,0 +1,205 @@
+// aging_scheduler.h
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+
+#include "task.h"
+
+// Prioridad efectiva con aging:
+// prioridad efectiva = base + (tiempo_espera_ms / aging_interval_ms)
+inline double aging_score(const Task& t,
+    std::chrono::steady_clock::time_point now,
+    double aging_interval_ms) {
+    using namespace std::chrono;
+    auto wait_ms = duration_cast<milliseconds>(now - t.enqueue_time).count();
+    return base_priority(t.type) + (double)wait_ms / aging_interval_ms;
+}
+
+// Colas FIFO por clase (A, M, B). Es la base de las políticas de
+// planificación (ver también scheduling_policies.h): todas guardan las
+// tareas igual y solo difieren en de qué cabeza extrae pop_next().
+class ClassQueues {
+public:
+    void push(const Task& t) {
+        buckets_[class_index(t.type)].push_back(t);
+        ++size_;
+    }
+
+    bool empty() const { return size_ == 0; }
+    std::size_t size() const { return size_; }
+
+    // Tareas pendientes de un tipo, O(1)
+    std::size_t count(char type) const {
+        return buckets_[class_index(type)].size();
+    }
+
+    void clear() {
+        for (auto& b : buckets_) b.clear();
+        size_ = 0;
+    }
+
+    // Cabeza de una clase (la más antigua) o nullptr si está vacía
+    const Task* head(std::size_t cls) const {
+        return buckets_[cls].empty() ? nullptr : &buckets_[cls].front();
+    }
+
+    // Descarta la tarea más antigua de la clase 'cls' (descarte por
+    // sobrecarga). Precondición: head(cls) != nullptr
+    Task evict_oldest(std::size_t cls) { return take(cls); }
+
+    // Saca la tarea 'id' de la clase 'cls' (vencida o cancelada); false si
+    // no está. La búsqueda es binaria por id: supone que cada clase recibe
+    // sus tareas en orden de id, como pasa cuando se numeran con el lock de
+    // la cola tomado (la simulación con el backend mutex).
+    bool erase(std::size_t cls, int id) { return erase_at(cls, find(cls, id)); }
+
+    // Recorre la cola en orden de llegada (mezcla las 3 clases por id).
+    // Solo lo usa el monitor para imprimir el estado, es O(n).
+    template <class F>
+    void for_each(F f) const {
+        std::array<std::size_t, NUM_CLASSES> pos{};
+        while (true) {
+            std::size_t next = NUM_CLASSES;
+            for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+                if (pos[c] == buckets_[c].size()) continue;
+                if (next == NUM_CLASSES ||
+                    buckets_[c][pos[c]].id < buckets_[next][pos[next]].id) {
+                    next = c;
+                }
+            }
+            if (next == NUM_CLASSES) return;
+            f(buckets_[next][pos[next]++]);
+        }
+    }
+
+protected:
+    // Saca la cabeza de la clase 'cls'. Precondición: head(cls) != nullptr
+    Task take(std::size_t cls) {
+        Task t = buckets_[cls].front();
+        buckets_[cls].pop_front();
+        --size_;
+        return t;
+    }
+
+    // Posición de 'id' en la clase 'cls' (el tamaño de la clase si no
+    // está), O(log n): las tareas de cada clase están en orden de id
+    std::size_t find(std::size_t cls, int id) const {
+        const auto& b = buckets_[cls];
+        auto it = std::lower_bound(b.begin(), b.end(), id,
+            [](const Task& t, int key) { return t.id < key; });
+        if (it == b.end() || it->id != id) return b.size();
+        return (std::size_t)(it - b.begin());
+    }
+
+    bool erase_at(std::size_t cls, std::size_t pos) {
+        if (pos >= buckets_[cls].size()) return false;
+        buckets_[cls].erase(buckets_[cls].begin() + (std::ptrdiff_t)pos);
+        --size_;
+        return true;
+    }
+
+    std::array<std::deque<Task>, NUM_CLASSES> buckets_;
+    std::size_t size_ = 0;
+};
+
+// Cola con aging indexada por clase.
+//
+// Cada clase (A, M, B) tiene su propia cola FIFO. Dentro de una clase la
+// tarea más antigua es siempre la de mayor puntaje (la base es la misma y
+// el tiempo de espera es mayor), así que basta con puntuar las 3 cabezas:
+// push y pop_next son O(1) sin importar cuántas tareas haya en cola.
+//
+// Elige exactamente la misma tarea que el recorrido lineal original:
+// mayor puntaje y, en empate, la que llegó primero a la cola (menor id).
+class AgingQueue : public ClassQueues {
+public:
+    static constexpr const char* NAME = "aging";
+
+    explicit AgingQueue(double aging_interval_ms = 200.0)
+        : aging_interval_ms_(aging_interval_ms) {
+    }
+
+    explicit AgingQueue(const PolicyParams& p)
+        : AgingQueue(p.aging_interval_ms) {
+    }
+
+    // Cambia la velocidad del aging para las próximas extracciones (lo usa
+    // el controlador adaptativo, ver aging_controller.h)
+    void set_aging_interval(double aging_interval_ms) { aging_interval_ms_ = aging_interval_ms; }
+    double aging_interval() const { return aging_interval_ms_; }
+
+    // Extrae la tarea con mayor prioridad efectiva en 'now'.
+    // Precondición: !empty()
+    Task pop_next(std::chrono::steady_clock::time_point now) {
+        std::size_t best = NUM_CLASSES;
+        double bestScore = -1e9;
+
+        for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+            if (buckets_[c].empty()) continue;
+            const Task& head = buckets_[c].front();
+            double score = aging_score(head, now, aging_interval_ms_);
+
+            if (best == NUM_CLASSES || score > bestScore) {
+                bestScore = score;
+                best = c;
+            }
+            else if (score == bestScore) {
+                // En empate, preferimos la más antigua
+                if (head.id < buckets_[best].front().id) {
+                    best = c;
+                }
+            }
+        }
+
+        return take(best);
+    }
+
+private:
+    double aging_interval_ms_;
+};
+
+// Implementación de referencia: recorrido lineal sobre toda la cola
+// (la versión original de select_task_index_unlocked). Se conserva para
+// comparar resultados y latencias en el benchmark del scheduler.
+class LinearAgingQueue {
+public:
+    explicit LinearAgingQueue(double aging_interval_ms = 200.0)
+        : aging_interval_ms_(aging_interval_ms) {
+    }
+
+    void push(const Task& t) { queue_.push_back(t); }
+    bool empty() const { return queue_.empty(); }
+    std::size_t size() const { return queue_.size(); }
+
+    Task pop_next(std::chrono::steady_clock::time_point now) {
+        double bestScore = -1e9;
+        std::size_t bestIdx = 0;
+
+        for (std::size_t i = 0; i < queue_.size(); ++i) {
+            const Task& t = queue_[i];
+            double score = aging_score(t, now, aging_interval_ms_);
+
+            if (score > bestScore) {
+                bestScore = score;
+                bestIdx = i;
+            }
+            else if (score == bestScore) {
+                // En empate, preferimos la más antigua
+                if (t.enqueue_time < queue_[bestIdx].enqueue_time) {
+                    bestIdx = i;
+                }
+            }
+        }
+
+        Task t = queue_[bestIdx];
+        queue_.erase(queue_.begin() + bestIdx);
+        return t;
+    }
+
+private:
+    double aging_interval_ms_;
+    std::deque<Task> queue_;
+};
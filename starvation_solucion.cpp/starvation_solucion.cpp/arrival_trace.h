@@ -0,0 +1,233 @@
+// arrival_trace.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Trazas binarias de llegadas: qué tarea entró a la cola y cuándo.
+//
+// Formato (registros de ancho fijo, en el orden de bytes de la máquina):
+//   cabecera  32 bytes: "ATRC", versión, cantidad de registros, mayor offset
+//   registro  16 bytes: microsegundos desde el inicio, id, clase
+// La cantidad y el mayor offset se escriben al cerrar; una traza cortada
+// (el proceso murió grabando) se lee igual hasta el último registro
+// completo.
+//
+// TraceWriter acumula registros en memoria y los escribe en bloques; lo
+// pueden usar varios hilos a la vez. TraceReader mapea el archivo en
+// memoria (mmap / MapViewOfFile) y lo recorre sin copiarlo, así una traza
+// de cientos de millones de llegadas no necesita caber en RAM.
+struct TraceHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t count;
+    std::uint64_t max_offset_us; // duración de la traza
+    std::uint64_t reserved;
+};
+
+struct TraceRecord {
+    std::uint64_t offset_us; // desde el inicio de la ejecución
+    std::uint32_t id;
+    char type;               // 'A', 'M', 'B'
+    char pad[3];
+};
+
+static_assert(sizeof(TraceHeader) == 32, "cabecera de traza de 32 bytes");
+static_assert(sizeof(TraceRecord) == 16, "registro de traza de 16 bytes");
+
+constexpr std::uint32_t TRACE_VERSION = 1;
+
+class TraceWriter {
+public:
+    explicit TraceWriter(const std::string& path)
+        : out_(path, std::ios::binary | std::ios::trunc)
+    {
+        if (!out_) throw std::invalid_argument("no se pudo crear la traza " + path);
+        write_header();
+        buf_.reserve(BLOCK);
+    }
+
+    ~TraceWriter() { close(); }
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    void append(long long offset_us, int id, char type) {
+        TraceRecord r{};
+        r.offset_us = (std::uint64_t)(offset_us < 0 ? 0 : offset_us);
+        r.id = (std::uint32_t)id;
+        r.type = type;
+
+        std::lock_guard<std::mutex> lk(mtx_);
+        buf_.push_back(r);
+        ++count_;
+        if (r.offset_us > max_offset_us_) max_offset_us_ = r.offset_us;
+        if (buf_.size() >= BLOCK) flush_unlocked();
+    }
+
+    // Escribe lo pendiente y la cantidad final en la cabecera
+    void close() {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (!out_.is_open()) return;
+        flush_unlocked();
+        out_.seekp(0);
+        write_header();
+        out_.close();
+    }
+
+    std::uint64_t count() const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return count_;
+    }
+
+private:
+    static constexpr std::size_t BLOCK = 4096; // registros por escritura (64 KB)
+
+    void write_header() {
+        TraceHeader h{};
+        std::memcpy(h.magic, "ATRC", 4);
+        h.version = TRACE_VERSION;
+        h.count = count_;
+        h.max_offset_us = max_offset_us_;
+        out_.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    }
+
+    void flush_unlocked() {
+        if (buf_.empty()) return;
+        out_.write(reinterpret_cast<const char*>(buf_.data()),
+            (std::streamsize)(buf_.size() * sizeof(TraceRecord)));
+        buf_.clear();
+    }
+
+    mutable std::mutex mtx_;
+    std::ofstream out_;
+    std::vector<TraceRecord> buf_;
+    std::uint64_t count_ = 0;
+    std::uint64_t max_offset_us_ = 0;
+};
+
+class TraceReader {
+public:
+    explicit TraceReader(const std::string& path) {
+        map(path);
+
+        if (bytes_ < sizeof(TraceHeader)) {
+            unmap();
+            throw std::invalid_argument(path + " no es una traza de llegadas");
+        }
+        TraceHeader h;
+        std::memcpy(&h, data_, sizeof(h));
+        if (std::memcmp(h.magic, "ATRC", 4) != 0 || h.version != TRACE_VERSION) {
+            unmap();
+            throw std::invalid_argument(path + " no es una traza de llegadas (version " +
+                std::to_string(TRACE_VERSION) + ")");
+        }
+
+        // Los registros completos que haya, aunque la cabecera diga otra cosa
+        std::uint64_t stored = (bytes_ - sizeof(TraceHeader)) / sizeof(TraceRecord);
+        records_ = reinterpret_cast<const TraceRecord*>(static_cast<const char*>(data_) + sizeof(TraceHeader));
+        if (h.count > 0 && h.count <= stored) {
+            count_ = (std::size_t)h.count;
+            duration_us_ = (long long)h.max_offset_us;
+        }
+        else {
+            // Sin cerrar: recorrer para saber la duración
+            count_ = (std::size_t)stored;
+            for (std::size_t i = 0; i < count_; ++i) {
+                if ((long long)records_[i].offset_us > duration_us_) duration_us_ = (long long)records_[i].offset_us;
+            }
+        }
+    }
+
+    ~TraceReader() { unmap(); }
+
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    std::size_t size() const { return count_; }
+    const TraceRecord& operator[](std::size_t i) const { return records_[i]; }
+
+    // Mayor offset de la traza (no tiene por qué ser el último registro:
+    // con varios productores el orden de grabación puede cruzarse)
+    long long duration_us() const { return duration_us_; }
+
+private:
+    void map(const std::string& path) {
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) throw std::invalid_argument("no se pudo abrir la traza " + path);
+        LARGE_INTEGER size{};
+        GetFileSizeEx(file_, &size);
+        bytes_ = (std::size_t)size.QuadPart;
+        if (bytes_ == 0) return;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_) data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        if (!data_) {
+            unmap();
+            throw std::invalid_argument("no se pudo mapear la traza " + path);
+        }
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) throw std::invalid_argument("no se pudo abrir la traza " + path);
+        struct stat st{};
+        if (fstat(fd_, &st) != 0) {
+            unmap();
+            throw std::invalid_argument("no se pudo leer la traza " + path);
+        }
+        bytes_ = (std::size_t)st.st_size;
+        if (bytes_ == 0) return;
+        void* p = mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (p == MAP_FAILED) {
+            unmap();
+            throw std::invalid_argument("no se pudo mapear la traza " + path);
+        }
+        data_ = p;
+        madvise(p, bytes_, MADV_SEQUENTIAL); // se lee de punta a punta
+#endif
+    }
+
+    void unmap() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) munmap(const_cast<void*>(data_), bytes_);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+        data_ = nullptr;
+    }
+
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    const void* data_ = nullptr;
+    std::size_t bytes_ = 0;
+    const TraceRecord* records_ = nullptr;
+    std::size_t count_ = 0;
+    long long duration_us_ = 0;
+};
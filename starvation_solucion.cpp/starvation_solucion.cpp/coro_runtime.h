@@ -0,0 +1,275 @@
+// coro_runtime.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Ejecución cooperativa con corrutinas de C++20.
+//
+// CoScheduler reparte corrutinas listas entre un grupo chico de hilos y
+// lleva un montículo de temporizadores: una corrutina que hace
+// co_await sched.sleep_for(d) no ocupa ningún hilo mientras espera, solo
+// su marco (unos cientos de bytes), así que miles de productores y
+// consumidores caben en pocos hilos. Las esperas por lugar o por tareas en
+// la cola las implementa quien tenga la cola (ver run_coroutines en
+// starvation_solucion.cpp.cpp): guarda el handle y lo devuelve con
+// schedule() cuando puede continuar.
+//
+// Una corrutina CoTask arranca con spawn() y su marco se libera solo al
+// terminar. join() espera a que terminen todas y detiene los hilos; hasta
+// entonces los hilos siguen vivos aunque no haya corrutinas.
+class CoScheduler;
+
+struct CoTask {
+    struct promise_type {
+        CoScheduler* sched = nullptr;
+
+        // Memoria de los marcos (para medir cuánto cuesta cada cliente)
+        static inline std::atomic<long long> live_bytes{ 0 };
+        static inline std::atomic<long long> peak_bytes{ 0 };
+        static inline std::atomic<long long> live_frames{ 0 };
+        static inline std::atomic<long long> peak_frames{ 0 };
+
+        static void* operator new(std::size_t n) {
+            void* p = ::operator new(n);
+            note_peak(peak_bytes, live_bytes.fetch_add((long long)n) + (long long)n);
+            note_peak(peak_frames, live_frames.fetch_add(1) + 1);
+            return p;
+        }
+        // El pico pasa a ser lo que está vivo ahora (antes de una medición)
+        static void reset_peak() {
+            peak_bytes = live_bytes.load();
+            peak_frames = live_frames.load();
+        }
+
+        static void operator delete(void* p, std::size_t n) {
+            live_bytes.fetch_sub((long long)n);
+            live_frames.fetch_sub(1);
+            ::operator delete(p);
+        }
+
+        CoTask get_return_object() {
+            return CoTask{ std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        // Al terminar: liberar el marco y avisar al planificador
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> h) noexcept;
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+
+    private:
+        static void note_peak(std::atomic<long long>& peak, long long v) {
+            long long prev = peak.load(std::memory_order_relaxed);
+            while (v > prev && !peak.compare_exchange_weak(prev, v, std::memory_order_relaxed)) {
+                // reintentar
+            }
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+class CoScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 'on_worker_start(i)' corre en cada hilo al arrancar (por ejemplo
+    // para fijar afinidad)
+    explicit CoScheduler(int workers, std::function<void(int)> on_worker_start = {})
+        : on_worker_start_(std::move(on_worker_start))
+    {
+        for (int i = 0; i < workers; ++i) {
+            threads_.emplace_back(&CoScheduler::worker_loop, this, i);
+        }
+    }
+
+    ~CoScheduler() { join(); }
+
+    CoScheduler(const CoScheduler&) = delete;
+    CoScheduler& operator=(const CoScheduler&) = delete;
+
+    void spawn(CoTask t) {
+        t.handle.promise().sched = this;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            ++live_;
+        }
+        schedule(t.handle);
+    }
+
+    // Reanudar 'h' en algún hilo del grupo
+    void schedule(std::coroutine_handle<> h) {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            ready_.push_back(h);
+        }
+        cv_.notify_one();
+    }
+
+    // co_await sched.sleep_for(d): suspende sin ocupar un hilo
+    auto sleep_for(Clock::duration d) {
+        struct Awaiter {
+            CoScheduler* s;
+            Clock::time_point when;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) {
+                if (when <= Clock::now()) s->schedule(h); // ceder el turno
+                else s->add_timer(when, h);
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{ this, Clock::now() + d };
+    }
+
+    // Espera a que terminen todas las corrutinas y detiene los hilos
+    void join() {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            closing_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : threads_) {
+            if (t.joinable()) t.join();
+        }
+    }
+
+    int workers() const { return (int)threads_.size(); }
+
+private:
+    friend struct CoTask::promise_type::FinalAwaiter;
+
+    struct Timer {
+        Clock::time_point when;
+        long long seq; // desempate FIFO
+        std::coroutine_handle<> h;
+        bool operator>(const Timer& o) const {
+            return when != o.when ? when > o.when : seq > o.seq;
+        }
+    };
+
+    void add_timer(Clock::time_point when, std::coroutine_handle<> h) {
+        bool earliest;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            earliest = timers_.empty() || when < timers_.top().when;
+            timers_.push({ when, timer_seq_++, h });
+        }
+        // Un hilo puede estar durmiendo hasta un vencimiento posterior
+        if (earliest) cv_.notify_one();
+    }
+
+    void on_finished() {
+        bool last;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            last = --live_ == 0;
+        }
+        if (last) cv_.notify_all();
+    }
+
+    void worker_loop(int index) {
+        if (on_worker_start_) on_worker_start_(index);
+
+        std::unique_lock<std::mutex> lk(mtx_);
+        for (;;) {
+            auto now = Clock::now();
+            while (!timers_.empty() && timers_.top().when <= now) {
+                ready_.push_back(timers_.top().h);
+                timers_.pop();
+            }
+
+            if (!ready_.empty()) {
+                std::coroutine_handle<> h = ready_.front();
+                ready_.pop_front();
+                lk.unlock();
+                h.resume();
+                lk.lock();
+                continue;
+            }
+
+            if (closing_ && live_ == 0) return;
+
+            if (timers_.empty()) {
+                cv_.wait(lk);
+            }
+            else {
+                // Copia: el montículo puede crecer mientras se espera
+                Clock::time_point until = timers_.top().when;
+                cv_.wait_until(lk, until);
+            }
+        }
+    }
+
+    std::function<void(int)> on_worker_start_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<std::coroutine_handle<>> ready_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    long long timer_seq_ = 0;
+    long long live_ = 0;   // corrutinas lanzadas que no terminaron
+    bool closing_ = false; // join(): salir cuando live_ llegue a 0
+};
+
+inline void CoTask::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+    CoScheduler* s = h.promise().sched;
+    h.destroy();
+    if (s) s->on_finished();
+}
+
+// Evento de una sola vez: las corrutinas que lo esperan se reanudan cuando
+// alguien llama a set()
+class CoEvent {
+public:
+    explicit CoEvent(CoScheduler& sched) : sched_(sched) {}
+
+    void set() {
+        std::vector<std::coroutine_handle<>> waiters;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            set_ = true;
+            waiters.swap(waiters_);
+        }
+        for (auto h : waiters) sched_.schedule(h);
+    }
+
+    auto operator co_await() {
+        struct Awaiter {
+            CoEvent* e;
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> h) {
+                std::lock_guard<std::mutex> lk(e->mtx_);
+                if (e->set_) return false;
+                e->waiters_.push_back(h);
+                return true;
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{ this };
+    }
+
+private:
+    CoScheduler& sched_;
+    std::mutex mtx_;
+    bool set_ = false;
+    std::vector<std::coroutine_handle<>> waiters_;
+};
@@ -0,0 +1,73 @@
+// elastic_pool.h
+#pragma once
+#include <algorithm>
+#include <cstddef>
+
+// Decide el tamaño del grupo de consumidores según la profundidad de la
+// cola y la tendencia de la espera, con histéresis.
+//
+// Se consulta una vez por período (scale_interval_ms) con la profundidad
+// actual y la espera promedio de las tareas extraídas en ese período:
+//   - presión: cola al menos a high_water de su capacidad, o espera
+//     promedio mayor que wait_high_ms y creciendo
+//   - holgura: cola con a lo sumo low_water tareas y espera promedio menor
+//     que wait_low_ms
+// Crece de a un consumidor tras up_samples períodos seguidos con presión y
+// se achica de a uno tras down_samples períodos seguidos con holgura
+// (bastante más largo: achicar de más cuesta backlog). Los umbrales
+// distintos para crecer y achicar evitan que el tamaño oscile.
+//
+// No es thread-safe: lo usa un solo hilo (el escalador o el bucle virtual).
+class PoolScaler {
+public:
+    struct Params {
+        int min_size = 1;
+        int max_size = 8;
+        double high_water = 0.75;    // fracción de MAX_QUEUE
+        std::size_t low_water = 1;   // tareas en cola
+        double wait_high_ms = 500.0;
+        double wait_low_ms = 100.0;
+        int up_samples = 2;
+        int down_samples = 10;
+    };
+
+    explicit PoolScaler(const Params& p) : params_(p) {}
+
+    void reset() {
+        up_streak_ = down_streak_ = 0;
+        prev_wait_ms_ = 0;
+    }
+
+    // Nuevo tamaño a partir del actual. 'avg_wait_ms' < 0 si en el período
+    // no salió ninguna tarea.
+    int decide(int active, std::size_t depth, std::size_t capacity, double avg_wait_ms) {
+        bool rising = avg_wait_ms >= 0 && avg_wait_ms >= prev_wait_ms_;
+        if (avg_wait_ms >= 0) prev_wait_ms_ = avg_wait_ms;
+
+        bool pressure = (double)depth >= params_.high_water * (double)capacity ||
+            (avg_wait_ms > params_.wait_high_ms && rising);
+        bool slack = depth <= params_.low_water && avg_wait_ms < params_.wait_low_ms;
+
+        up_streak_ = pressure ? up_streak_ + 1 : 0;
+        down_streak_ = slack ? down_streak_ + 1 : 0;
+
+        int next = active;
+        if (up_streak_ >= params_.up_samples) {
+            next = active + 1;
+        }
+        else if (down_streak_ >= params_.down_samples) {
+            next = active - 1;
+        }
+        next = std::clamp(next, params_.min_size, params_.max_size);
+        if (next != active) up_streak_ = down_streak_ = 0;
+        return next;
+    }
+
+    const Params& params() const { return params_; }
+
+private:
+    Params params_;
+    int up_streak_ = 0;
+    int down_streak_ = 0;
+    double prev_wait_ms_ = 0;
+};
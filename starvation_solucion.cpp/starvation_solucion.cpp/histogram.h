@@ -0,0 +1,86 @@
+// histogram.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Histograma de latencias con buckets logarítmicos (estilo HDR), sin locks.
+//
+// Los valores (microsegundos) se agrupan por potencia de 2 y cada potencia
+// se divide en 2^SUB_BITS sub-buckets lineales, así el error relativo de
+// cualquier percentil es menor a 1 / 2^SUB_BITS (~3%). record() es un
+// fetch_add relaxed, lo pueden llamar todos los consumidores a la vez.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr std::int64_t SUB_COUNT = std::int64_t(1) << SUB_BITS;
+    static constexpr int MAX_MAGNITUDE = 40; // hasta ~2^40 us (12 días)
+    static constexpr std::size_t NUM_BUCKETS = (std::size_t)((MAX_MAGNITUDE - SUB_BITS + 2) * SUB_COUNT);
+
+    void record(std::int64_t value_us) {
+        if (value_us < 0) value_us = 0;
+        buckets_[bucket_index(value_us)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+
+        std::int64_t prev = max_.load(std::memory_order_relaxed);
+        while (value_us > prev &&
+            !max_.compare_exchange_weak(prev, value_us, std::memory_order_relaxed)) {
+            // reintentar
+        }
+    }
+
+    // Solo cuando nadie está registrando (antes de lanzar los hilos)
+    void reset() {
+        for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    std::int64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // Valor (us) por debajo del cual queda la fracción 'q' de las muestras
+    // (q en [0, 1]). Devuelve el límite superior del bucket, acotado por el
+    // máximo observado. Con hilos registrando es una foto aproximada.
+    std::int64_t percentile(double q) const {
+        std::uint64_t total = count();
+        if (total == 0) return 0;
+        std::uint64_t rank = (std::uint64_t)(q * (double)total + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > total) rank = total;
+
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < NUM_BUCKETS; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                std::int64_t upper = bucket_upper(i);
+                std::int64_t mx = max();
+                return upper < mx ? upper : mx;
+            }
+        }
+        return max();
+    }
+
+private:
+    static std::size_t bucket_index(std::int64_t v) {
+        if (v < SUB_COUNT) return (std::size_t)v;
+        int magnitude = 63;
+        while (!((std::uint64_t)v >> magnitude)) --magnitude; // floor(log2(v))
+        if (magnitude > MAX_MAGNITUDE) return NUM_BUCKETS - 1;
+        int shift = magnitude - SUB_BITS;
+        std::int64_t sub = (v >> shift) - SUB_COUNT; // 0 .. SUB_COUNT-1
+        return (std::size_t)((shift + 1) * SUB_COUNT + sub);
+    }
+
+    // Mayor valor que cae en el bucket i
+    static std::int64_t bucket_upper(std::size_t i) {
+        if ((std::int64_t)i < SUB_COUNT) return (std::int64_t)i;
+        std::int64_t shift = (std::int64_t)i / SUB_COUNT - 1;
+        std::int64_t sub = (std::int64_t)i % SUB_COUNT;
+        return ((SUB_COUNT + sub + 1) << shift) - 1;
+    }
+
+    std::atomic<std::uint64_t> buckets_[NUM_BUCKETS] = {};
+    std::atomic<std::uint64_t> count_{ 0 };
+    std::atomic<std::int64_t> max_{ 0 };
+};
@@ -0,0 +1,229 @@
+// lockfree_queue.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "task.h"
+#include "aging_scheduler.h"
+#include "parking.h"
+
+// Anillo acotado MPMC sin locks (algoritmo de D. Vyukov) para las tareas
+// de una sola clase. Cada celda tiene un número de secuencia:
+//   seq == pos      -> libre para el productor que reclame 'pos'
+//   seq == pos + 1  -> publicada para el consumidor que reclame 'pos'
+//
+// Los datos de la tarea se guardan en atómicos (relaxed) para que un
+// consumidor pueda espiar la cabeza con peek() sin carrera de datos y
+// decidir con aging antes de reclamarla con try_pop_at(). Se guardan el
+// nodo de origen y el plazo además de id y llegada; el peso no, porque la
+// política weighted solo existe con el backend mutex.
+class TaskRing {
+public:
+    struct Head {
+        std::size_t pos;
+        int id;
+        std::chrono::steady_clock::time_point enqueue_time;
+    };
+
+    explicit TaskRing(std::size_t min_capacity) {
+        std::size_t cap = 1;
+        while (cap < min_capacity) cap <<= 1;
+        mask_ = cap - 1;
+        cells_ = std::make_unique<Cell[]>(cap);
+        for (std::size_t i = 0; i < cap; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // false si la celda siguiente todavía no fue liberada por su consumidor
+    bool try_push(const Task& t) {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells_[pos & mask_];
+            std::size_t seq = c.seq.load(std::memory_order_acquire);
+            std::intptr_t dif = (std::intptr_t)seq - (std::intptr_t)pos;
+            if (dif == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                    std::memory_order_relaxed)) {
+                    c.ticks.store(t.enqueue_time.time_since_epoch().count(),
+                        std::memory_order_relaxed);
+                    c.id.store(t.id, std::memory_order_relaxed);
+                    c.node.store(t.node, std::memory_order_relaxed);
+                    c.deadline.store(t.deadline.time_since_epoch().count(),
+                        std::memory_order_relaxed);
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0) {
+                return false;
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Lee la cabeza sin extraerla. Es solo una pista: puede quedar vieja en
+    // cuanto retorna, por eso try_pop_at() revalida la posición con un CAS.
+    bool peek(Head& h) const {
+        for (;;) {
+            std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            const Cell& c = cells_[pos & mask_];
+            std::size_t seq = c.seq.load(std::memory_order_acquire);
+            std::intptr_t dif = (std::intptr_t)seq - (std::intptr_t)(pos + 1);
+            if (dif < 0) return false; // vacía
+            if (dif > 0) continue;     // otro consumidor se la llevó
+            h.pos = pos;
+            h.id = c.id.load(std::memory_order_relaxed);
+            h.enqueue_time = std::chrono::steady_clock::time_point(
+                std::chrono::steady_clock::duration(
+                    c.ticks.load(std::memory_order_relaxed)));
+            return true;
+        }
+    }
+
+    // Extrae la tarea en 'pos' solo si sigue siendo la cabeza
+    bool try_pop_at(std::size_t pos, char type, Task& out) {
+        std::size_t expected = pos;
+        if (!dequeue_pos_.compare_exchange_strong(expected, pos + 1,
+            std::memory_order_relaxed)) {
+            return false;
+        }
+        Cell& c = cells_[pos & mask_];
+        out.type = type;
+        out.id = c.id.load(std::memory_order_relaxed);
+        out.enqueue_time = std::chrono::steady_clock::time_point(
+            std::chrono::steady_clock::duration(
+                c.ticks.load(std::memory_order_relaxed)));
+        out.node = c.node.load(std::memory_order_relaxed);
+        out.deadline = std::chrono::steady_clock::time_point(
+            std::chrono::steady_clock::duration(
+                c.deadline.load(std::memory_order_relaxed)));
+        c.seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Aproximado si hay operaciones en curso
+    std::size_t size() const {
+        std::size_t enq = enqueue_pos_.load(std::memory_order_relaxed);
+        std::size_t deq = dequeue_pos_.load(std::memory_order_relaxed);
+        return enq > deq ? enq - deq : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> seq{ 0 };
+        std::atomic<std::int64_t> ticks{ 0 };
+        std::atomic<int> id{ 0 };
+        std::atomic<int> node{ -1 };
+        std::atomic<std::int64_t> deadline{ 0 };
+    };
+
+    // Posiciones en líneas de caché distintas para no compartirlas
+    alignas(64) std::atomic<std::size_t> enqueue_pos_{ 0 };
+    alignas(64) std::atomic<std::size_t> dequeue_pos_{ 0 };
+    alignas(64) std::size_t mask_ = 0;
+    std::unique_ptr<Cell[]> cells_;
+};
+
+// Backend sin locks para Simulation: un TaskRing por clase y un contador
+// global que acota el total a 'max_size' (el MAX_QUEUE de la simulación).
+//
+// El consumidor espía las 3 cabezas, las puntúa con la misma fórmula de
+// aging que AgingQueue y reclama esa posición exacta; si otro consumidor se
+// adelantó, reintenta. Solo se bloquea (parking con std::atomic::wait)
+// cuando la cola está llena o vacía.
+//
+// El orden es aproximado: el id y enqueue_time se asignan antes de
+// publicar en el anillo, así que dos productores de la misma clase pueden
+// publicar en orden inverso y la cabeza no es siempre la tarea más antigua
+// de su clase (ni el desempate por id exacto). La diferencia está acotada
+// por lo que tarda un productor entre crear la tarea y publicarla.
+class LockFreeTaskQueue {
+public:
+    LockFreeTaskQueue(std::size_t max_size, double aging_interval_ms)
+        : max_size_(max_size),
+        aging_interval_ms_(aging_interval_ms),
+        rings_{ TaskRing(max_size), TaskRing(max_size), TaskRing(max_size) }
+    {
+    }
+
+    bool try_push(const Task& t) {
+        // Reservar un lugar en el total
+        std::size_t c = count_.load(std::memory_order_relaxed);
+        do {
+            if (c >= max_size_) return false;
+        } while (!count_.compare_exchange_weak(c, c + 1, std::memory_order_acq_rel));
+
+        // Con la reserva hecha el anillo tiene espacio lógico; si la celda
+        // aún no fue liberada es porque un consumidor está terminando de leerla.
+        TaskRing& ring = rings_[class_index(t.type)];
+        while (!ring.try_push(t)) {
+            std::this_thread::yield();
+        }
+        not_empty_.signal();
+        return true;
+    }
+
+    bool try_pop(Task& out, std::chrono::steady_clock::time_point now) {
+        for (;;) {
+            std::size_t best = NUM_CLASSES;
+            double bestScore = -1e9;
+            TaskRing::Head heads[NUM_CLASSES];
+
+            for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+                if (!rings_[c].peek(heads[c])) continue;
+                Task probe{ class_type(c), heads[c].id, heads[c].enqueue_time };
+                double score = aging_score(probe, now, aging_interval_ms_);
+                if (best == NUM_CLASSES || score > bestScore ||
+                    (score == bestScore && heads[c].id < heads[best].id)) {
+                    bestScore = score;
+                    best = c;
+                }
+            }
+            if (best == NUM_CLASSES) return false;
+
+            if (rings_[best].try_pop_at(heads[best].pos, class_type(best), out)) {
+                count_.fetch_sub(1, std::memory_order_acq_rel);
+                not_full_.signal();
+                return true;
+            }
+            // Otro consumidor tomó esa cabeza: volver a mirar
+        }
+    }
+
+    // Inserción bloqueante; false si 'stop' se activó antes de insertar
+    bool push(const Task& t, const std::atomic<bool>& stop) {
+        return not_full_.wait_until([&] { return try_push(t); }, stop);
+    }
+
+    // Extracción bloqueante; false si 'stop' se activó
+    bool pop(Task& out, const std::atomic<bool>& stop) {
+        return not_empty_.wait_until(
+            [&] { return try_pop(out, std::chrono::steady_clock::now()); }, stop);
+    }
+
+    // Despierta a todos los hilos estacionados (para detenerlos)
+    void wake_all() {
+        not_full_.wake_all();
+        not_empty_.wake_all();
+    }
+
+    std::size_t size() const { return count_.load(std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+    std::size_t count(char type) const { return rings_[class_index(type)].size(); }
+
+private:
+    const std::size_t max_size_;
+    const double aging_interval_ms_;
+    TaskRing rings_[NUM_CLASSES];
+
+    alignas(64) std::atomic<std::size_t> count_{ 0 };
+    ParkingSpot not_empty_;
+    ParkingSpot not_full_;
+};
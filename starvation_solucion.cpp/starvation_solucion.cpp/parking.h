@@ -0,0 +1,57 @@
+// parking.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lugar donde se estacionan hilos que esperan un cambio de estado de una
+// estructura sin locks (cola no vacía, cola no llena...). Sustituye al par
+// mutex + condition_variable usando std::atomic::wait/notify.
+class ParkingSpot {
+public:
+    // Avisar que el estado cambió. Solo se toca el epoch (y se hace la
+    // llamada al sistema) si hay alguien estacionado. El fence empareja con
+    // el de wait_until(): o quien avisa ve al que espera, o el que espera ve
+    // el cambio de estado.
+    void signal() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) > 0) {
+            epoch_.fetch_add(1);
+            epoch_.notify_one();
+        }
+    }
+
+    // Despierta a todos los hilos estacionados (para detenerlos)
+    void wake_all() {
+        epoch_.fetch_add(1);
+        epoch_.notify_all();
+    }
+
+    // Reintenta 'op' unas cuantas veces y, si sigue fallando, se estaciona
+    // hasta que signal() o wake_all() cambien el epoch. Devuelve false si
+    // 'stop' se activó antes de que 'op' tuviera éxito.
+    template <class Op>
+    bool wait_until(Op op, const std::atomic<bool>& stop) {
+        for (;;) {
+            for (int i = 0; i < SPIN_TRIES; ++i) {
+                if (op()) return true;
+            }
+            if (stop.load()) return false;
+
+            std::uint32_t seen = epoch_.load();
+            waiters_.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool done = op();
+            if (!done && !stop.load()) {
+                epoch_.wait(seen);
+            }
+            waiters_.fetch_sub(1);
+            if (done) return true;
+        }
+    }
+
+private:
+    static constexpr int SPIN_TRIES = 16;
+
+    alignas(64) std::atomic<std::uint32_t> epoch_{ 0 };
+    std::atomic<int> waiters_{ 0 };
+};
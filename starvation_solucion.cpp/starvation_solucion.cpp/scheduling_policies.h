@@ -0,0 +1,197 @@
+// scheduling_policies.h
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+
+#include "task.h"
+#include "aging_scheduler.h"
+
+// Políticas de planificación para la cola de la simulación.
+//
+// Todas tienen la misma interfaz que AgingQueue (push, pop_next, size,
+// count, clear, for_each) y se eligen en compilación como parámetro de
+// plantilla de Simulation, así que la extracción no pasa por funciones
+// virtuales. Todas guardan una FIFO por clase (ClassQueues) y solo miran
+// las 3 cabezas: pop_next es O(1).
+//
+//   StrictPriorityQueue  A > M > B siempre (la versión con starvation)
+//   AgingQueue           prioridad base + espera / aging_interval_ms
+//   WeightedFairQueue    reparte el tiempo de servicio según 'share'
+//   DeficitRoundRobin    turnos con crédito proporcional a 'share'
+//   EarliestDeadlineQueue  plazo = llegada + deadline_ms de la clase
+
+// Prioridad estricta: la primera clase no vacía en orden A, M, B
+class StrictPriorityQueue : public ClassQueues {
+public:
+    static constexpr const char* NAME = "strict";
+
+    explicit StrictPriorityQueue(const PolicyParams& = PolicyParams()) {}
+
+    Task pop_next(std::chrono::steady_clock::time_point) {
+        std::size_t c = 0;
+        while (buckets_[c].empty()) ++c;
+        return take(c);
+    }
+};
+
+// Weighted fair queueing (variante self-clocked): cada tarea recibe al
+// llegar una etiqueta de fin = max(V, fin anterior de su clase) +
+// costo / peso, y se atiende la menor etiqueta. V es la etiqueta de la
+// última tarea atendida. A la larga cada clase con trabajo pendiente
+// recibe tiempo de servicio proporcional a su 'share'.
+class WeightedFairQueue : public ClassQueues {
+public:
+    static constexpr const char* NAME = "wfq";
+
+    explicit WeightedFairQueue(const PolicyParams& p = PolicyParams()) {
+        for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+            step_[c] = (double)std::max(p.cost_ms[c], 1) / std::max(p.share[c], 1);
+        }
+    }
+
+    void push(const Task& t) {
+        std::size_t c = class_index(t.type);
+        last_finish_[c] = std::max(virtual_time_, last_finish_[c]) + step_[c];
+        tags_[c].push_back(last_finish_[c]);
+        ClassQueues::push(t);
+    }
+
+    Task evict_oldest(std::size_t cls) {
+        tags_[cls].pop_front();
+        return take(cls);
+    }
+
+    bool erase(std::size_t cls, int id) {
+        std::size_t pos = find(cls, id);
+        if (pos < tags_[cls].size()) tags_[cls].erase(tags_[cls].begin() + (std::ptrdiff_t)pos);
+        return erase_at(cls, pos);
+    }
+
+    void clear() {
+        ClassQueues::clear();
+        for (auto& t : tags_) t.clear();
+        last_finish_ = {};
+        virtual_time_ = 0;
+    }
+
+    Task pop_next(std::chrono::steady_clock::time_point) {
+        std::size_t best = NUM_CLASSES;
+        for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+            if (buckets_[c].empty()) continue;
+            if (best == NUM_CLASSES || tags_[c].front() < tags_[best].front() ||
+                (tags_[c].front() == tags_[best].front() &&
+                    buckets_[c].front().id < buckets_[best].front().id)) {
+                best = c;
+            }
+        }
+
+        virtual_time_ = tags_[best].front();
+        tags_[best].pop_front();
+        return take(best);
+    }
+
+private:
+    std::array<double, NUM_CLASSES> step_{};
+    std::array<double, NUM_CLASSES> last_finish_{};
+    std::array<std::deque<double>, NUM_CLASSES> tags_;
+    double virtual_time_ = 0;
+};
+
+// Deficit round robin: las clases se visitan en turno A, M, B. En cada
+// visita la clase suma su quantum (share * mayor costo) al crédito y
+// atiende tareas mientras el crédito cubra su costo. Una clase que se
+// vacía pierde el crédito acumulado.
+class DeficitRoundRobin : public ClassQueues {
+public:
+    static constexpr const char* NAME = "drr";
+
+    explicit DeficitRoundRobin(const PolicyParams& p = PolicyParams()) {
+        int maxCost = 1;
+        for (int c : p.cost_ms) maxCost = std::max(maxCost, c);
+        for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+            cost_[c] = std::max(p.cost_ms[c], 1);
+            quantum_[c] = (long long)std::max(p.share[c], 1) * maxCost;
+        }
+    }
+
+    void clear() {
+        ClassQueues::clear();
+        deficit_ = {};
+        current_ = 0;
+        credited_ = false;
+    }
+
+    // Precondición: !empty(). Termina porque alguna clase tiene tareas y
+    // su crédito crece en cada visita.
+    Task pop_next(std::chrono::steady_clock::time_point) {
+        for (;;) {
+            std::size_t c = current_;
+            if (buckets_[c].empty()) {
+                deficit_[c] = 0;
+                advance();
+                continue;
+            }
+            if (!credited_) {
+                deficit_[c] += quantum_[c];
+                credited_ = true;
+            }
+            if (cost_[c] <= deficit_[c]) {
+                deficit_[c] -= cost_[c];
+                Task t = take(c);
+                if (buckets_[c].empty()) {
+                    deficit_[c] = 0;
+                    advance();
+                }
+                return t;
+            }
+            advance();
+        }
+    }
+
+private:
+    void advance() {
+        current_ = (current_ + 1) % NUM_CLASSES;
+        credited_ = false;
+    }
+
+    std::array<long long, NUM_CLASSES> cost_{};
+    std::array<long long, NUM_CLASSES> quantum_{};
+    std::array<long long, NUM_CLASSES> deficit_{};
+    std::size_t current_ = 0;
+    bool credited_ = false;
+};
+
+// Earliest deadline first: plazo = enqueue_time + deadline_ms de la clase.
+// Dentro de una clase el plazo crece con la llegada, así que la cabeza es
+// siempre la de plazo más cercano. En empate, la más antigua (menor id).
+class EarliestDeadlineQueue : public ClassQueues {
+public:
+    static constexpr const char* NAME = "edf";
+
+    explicit EarliestDeadlineQueue(const PolicyParams& p = PolicyParams()) {
+        for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+            deadline_[c] = std::chrono::milliseconds(p.deadline_ms[c]);
+        }
+    }
+
+    Task pop_next(std::chrono::steady_clock::time_point) {
+        std::size_t best = NUM_CLASSES;
+        std::chrono::steady_clock::time_point bestDeadline;
+        for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+            if (buckets_[c].empty()) continue;
+            auto d = buckets_[c].front().enqueue_time + deadline_[c];
+            if (best == NUM_CLASSES || d < bestDeadline ||
+                (d == bestDeadline && buckets_[c].front().id < buckets_[best].front().id)) {
+                best = c;
+                bestDeadline = d;
+            }
+        }
+        return take(best);
+    }
+
+private:
+    std::array<std::chrono::steady_clock::duration, NUM_CLASSES> deadline_{};
+};
@@ -0,0 +1,631 @@
+// shared_queue.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "task.h"
+#include "aging_scheduler.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+// Cola con aging en un segmento de memoria compartida con nombre, para
+// que productores y consumidores vivan en procesos distintos.
+//
+// El segmento tiene una cabecera (estado y sincronización) y un anillo de
+// registros de 16 bytes por clase. El productor escribe la tarea
+// directamente en el anillo y el consumidor la lee de ahí: sin sockets,
+// sin copias al kernel y, sin contención, sin llamadas al sistema (el
+// mutex solo entra al kernel cuando hay que esperar). El consumidor elige
+// entre las 3 cabezas con la misma regla que AgingQueue: mayor puntaje y,
+// en empate, menor id. Los ids salen de un contador del segmento, así son
+// únicos y crecientes entre todos los procesos.
+//
+// Sincronización entre procesos:
+//   POSIX    pthread_mutex con PTHREAD_PROCESS_SHARED dentro del segmento
+//            (shm_open). El mutex es robusto: si un proceso muere con el
+//            lock tomado, el siguiente lo recupera. Para esperar no se usa
+//            pthread_cond: en glibc un proceso que muere esperando deja la
+//            variable de condición trabada para los demás. Cada condición es
+//            un contador de avisos: en Linux se espera con futex sobre ese
+//            contador; en otros sistemas, con una pausa corta.
+//   Windows  mutex y semáforos con nombre (Local\<nombre>.*) junto al
+//            mapeo con nombre (CreateFileMapping).
+// Las esperas tienen un tope corto y vuelven a mirar el estado, así un
+// aviso perdido o un 'stop' local solo cuestan unos ms. Si un proceso muere
+// con el lock tomado, quien lo recupera recalcula los contadores a partir
+// de los índices de los anillos.
+//
+// Cada proceso productor anota su PID en la cabecera. El consumidor quita
+// los PID de procesos que ya no existen (murieron sin despedirse), así que
+// un productor caído no lo deja esperando para siempre.
+//
+// enqueue_time se guarda en ticks de steady_clock: en Linux
+// (CLOCK_MONOTONIC) y en Windows (QueryPerformanceCounter) es el mismo
+// reloj para todos los procesos de la máquina, así que la espera medida
+// por el consumidor incluye el tiempo en la cola del otro proceso.
+//
+// Quien crea el segmento (el consumidor) anota su PID y lo borra al
+// destruirse. Un segmento con el mismo nombre solo se reemplaza si su
+// creador ya no existe (quedó de una ejecución que murió); si sigue vivo,
+// create falla con "segmento en uso". Las fallas del sistema operativo
+// (crear o mapear el segmento) se informan con std::system_error.
+class SharedTaskQueue {
+public:
+    static std::unique_ptr<SharedTaskQueue> create(const std::string& name, std::size_t max_size,
+        double aging_interval_ms) {
+        std::unique_ptr<SharedTaskQueue> q(new SharedTaskQueue(name));
+        q->map(true, bytes_for(max_size));
+        q->init(max_size, aging_interval_ms);
+        return q;
+    }
+
+    // Se conecta a un segmento que creó otro proceso; lo espera hasta
+    // 'wait' por si el consumidor todavía no arrancó
+    static std::unique_ptr<SharedTaskQueue> open(const std::string& name,
+        std::chrono::milliseconds wait = std::chrono::milliseconds(10000)) {
+        std::unique_ptr<SharedTaskQueue> q(new SharedTaskQueue(name));
+        auto deadline = std::chrono::steady_clock::now() + wait;
+        while (!q->map(false, 0)) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                throw std::invalid_argument("no existe el segmento compartido " + name);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        // El creador publica 'ready' al terminar de inicializar
+        while (q->header_->ready.load(std::memory_order_acquire) != READY) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                throw std::invalid_argument("el segmento " + name + " no se inicializo");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        q->open_sync();
+        return q;
+    }
+
+    ~SharedTaskQueue() { unmap(); }
+
+    SharedTaskQueue(const SharedTaskQueue&) = delete;
+    SharedTaskQueue& operator=(const SharedTaskQueue&) = delete;
+
+    const std::string& name() const { return name_; }
+    bool owner() const { return owner_; }
+    std::size_t capacity() const { return (std::size_t)header_->capacity; }
+    double aging_interval_ms() const { return header_->aging_interval_ms; }
+
+    // Id único entre todos los procesos conectados
+    int next_id() { return header_->next_id.fetch_add(1, std::memory_order_relaxed); }
+
+    bool try_push(const Task& t) {
+        Lock lk(*this);
+        if (!push_locked(t)) return false;
+        signal(NOT_EMPTY, false);
+        return true;
+    }
+
+    // Inserción bloqueante; false si 'stop' se activó antes de insertar
+    bool push(const Task& t, const std::atomic<bool>& stop) {
+        Lock lk(*this);
+        while (!push_locked(t)) {
+            if (stop.load()) return false;
+            wait(NOT_FULL);
+        }
+        signal(NOT_EMPTY, false);
+        return true;
+    }
+
+    bool try_pop(Task& out, std::chrono::steady_clock::time_point now) {
+        Lock lk(*this);
+        if (!pop_locked(out, now)) return false;
+        signal(NOT_FULL, false);
+        return true;
+    }
+
+    // Extracción bloqueante; false si 'stop' se activó
+    bool pop(Task& out, const std::atomic<bool>& stop) {
+        Lock lk(*this);
+        while (!pop_locked(out, std::chrono::steady_clock::now())) {
+            if (stop.load()) return false;
+            wait(NOT_EMPTY);
+        }
+        signal(NOT_FULL, false);
+        return true;
+    }
+
+    // Despierta a los hilos que esperan (de este y de los otros procesos;
+    // los demás vuelven a dormir)
+    void wake_all() {
+        Lock lk(*this);
+        signal(NOT_FULL, true);
+        signal(NOT_EMPTY, true);
+    }
+
+    std::size_t size() const { return (std::size_t)header_->size.load(std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+    std::size_t count(char type) const {
+        return (std::size_t)header_->count[class_index(type)].load(std::memory_order_relaxed);
+    }
+
+    // Procesos productores: cada uno se anuncia al empezar y se despide al
+    // terminar, así el consumidor sabe cuándo no van a llegar más tareas
+    void attach_producer() {
+        Lock lk(*this);
+        std::int64_t pid = current_pid();
+        for (auto& p : header_->producer_pid) {
+            if (p == 0) {
+                p = pid;
+                ++header_->producers_seen;
+                return;
+            }
+        }
+        throw std::invalid_argument("demasiados procesos productores en " + name_ +
+            " (maximo " + std::to_string(MAX_PRODUCERS) + ")");
+    }
+
+    void detach_producer() {
+        Lock lk(*this);
+        std::int64_t pid = current_pid();
+        for (auto& p : header_->producer_pid) {
+            if (p == pid) p = 0;
+        }
+        signal(NOT_EMPTY, true);
+    }
+
+    // true cuando ya se conectaron 'expected' procesos productores y se
+    // desconectaron todos (o murieron). Espera a lo sumo 'timeout'.
+    bool wait_producers_done(int expected, std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        Lock lk(*this);
+        for (;;) {
+            reap_dead_producers();
+            if (header_->producers_seen >= expected && live_producers() == 0) return true;
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            wait(NOT_EMPTY);
+        }
+    }
+
+    // Procesos productores que se conectaron alguna vez, los que siguen
+    // conectados y los que murieron sin despedirse
+    int producer_processes() {
+        Lock lk(*this);
+        return header_->producers_seen;
+    }
+
+    int connected_producers() {
+        Lock lk(*this);
+        return live_producers();
+    }
+
+    int dead_producers() {
+        Lock lk(*this);
+        return header_->producers_dead;
+    }
+
+private:
+    static constexpr std::uint32_t VERSION = 3;
+    static constexpr int MAX_PRODUCERS = 64;
+    static constexpr std::uint32_t READY = 0x52454459; // "READ"
+    static constexpr long WAIT_MS = 50; // tope de cada espera
+    enum Cond { NOT_EMPTY, NOT_FULL, NUM_CONDS };
+
+    // Registro de una tarea en el anillo (la clase es la del anillo)
+    struct Slot {
+        std::int64_t enqueue_ticks;
+        std::int32_t id;
+        std::int32_t node;
+    };
+    static_assert(sizeof(Slot) == 16, "registro de 16 bytes");
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::atomic<std::uint32_t> ready;
+        std::uint64_t capacity;              // de cada anillo (= total máximo)
+        double aging_interval_ms;
+        std::int64_t owner_pid;              // proceso que creó el segmento
+#ifndef _WIN32
+        pthread_mutex_t mtx;
+        std::atomic<std::uint32_t> seq[NUM_CONDS]; // avisos de cada condición (futex)
+#endif
+        long waiters[NUM_CONDS];             // hilos esperando en cada condición
+        std::uint64_t head[NUM_CLASSES];     // próximas a extraer / insertar
+        std::uint64_t tail[NUM_CLASSES];
+        std::atomic<std::uint64_t> size;     // lecturas sin lock para el monitor
+        std::atomic<std::uint64_t> count[NUM_CLASSES];
+        std::atomic<int> next_id;
+        std::int64_t producer_pid[MAX_PRODUCERS]; // conectados (0 = libre)
+        int producers_seen;                  // conectados alguna vez
+        int producers_dead;                  // quitados por reap_dead_producers
+    };
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+        std::atomic<int>::is_always_lock_free, "los atomicos del segmento deben ser lock-free");
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "futex de 32 bits");
+
+    static std::size_t slots_offset() { return (sizeof(Header) + 63) / 64 * 64; }
+    static std::size_t bytes_for(std::size_t max_size) {
+        return slots_offset() + NUM_CLASSES * max_size * sizeof(Slot);
+    }
+
+    explicit SharedTaskQueue(const std::string& name) : name_(name) {}
+
+    Slot* ring(std::size_t cls) {
+        return reinterpret_cast<Slot*>(static_cast<char*>(base_) + slots_offset()) + cls * header_->capacity;
+    }
+
+    // Con el lock tomado
+    int live_producers() const {
+        int n = 0;
+        for (std::int64_t p : header_->producer_pid) n += p != 0;
+        return n;
+    }
+
+    // Con el lock tomado: libera los lugares de productores que ya no existen.
+    // Un PID reutilizado por otro proceso se toma por vivo; en ese caso
+    // solo el plazo del consumidor lo corta.
+    void reap_dead_producers() {
+        for (auto& p : header_->producer_pid) {
+            if (p != 0 && !process_alive(p)) {
+                p = 0;
+                ++header_->producers_dead;
+            }
+        }
+    }
+
+    // Con el lock recuperado de un proceso que murió: push_locked y
+    // pop_locked mueven el índice antes que los contadores, así que los
+    // contadores se recalculan a partir de head/tail
+    void repair_locked() {
+        Header& h = *header_;
+        std::uint64_t total = 0;
+        for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+            std::uint64_t n = h.tail[c] - h.head[c];
+            h.count[c].store(n, std::memory_order_relaxed);
+            total += n;
+        }
+        h.size.store(total, std::memory_order_relaxed);
+    }
+
+    bool push_locked(const Task& t) {
+        Header& h = *header_;
+        if (h.size.load(std::memory_order_relaxed) >= h.capacity) return false;
+        std::size_t c = class_index(t.type);
+        Slot& s = ring(c)[h.tail[c] % h.capacity];
+        s.enqueue_ticks = (std::int64_t)t.enqueue_time.time_since_epoch().count();
+        s.id = t.id;
+        s.node = t.node;
+        ++h.tail[c];
+        h.count[c].fetch_add(1, std::memory_order_relaxed);
+        h.size.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Misma elección que AgingQueue::pop_next sobre las 3 cabezas
+    bool pop_locked(Task& out, std::chrono::steady_clock::time_point now) {
+        Header& h = *header_;
+        std::size_t best = NUM_CLASSES;
+        double bestScore = -1e9;
+        Task heads[NUM_CLASSES];
+        for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+            if (h.head[c] == h.tail[c]) continue;
+            const Slot& s = ring(c)[h.head[c] % h.capacity];
+            heads[c].type = class_type(c);
+            heads[c].id = s.id;
+            heads[c].node = s.node;
+            heads[c].enqueue_time = std::chrono::steady_clock::time_point(
+                std::chrono::steady_clock::duration(s.enqueue_ticks));
+            double score = aging_score(heads[c], now, h.aging_interval_ms);
+            if (best == NUM_CLASSES || score > bestScore ||
+                (score == bestScore && heads[c].id < heads[best].id)) {
+                bestScore = score;
+                best = c;
+            }
+        }
+        if (best == NUM_CLASSES) return false;
+
+        out = heads[best];
+        ++h.head[best];
+        h.count[best].fetch_sub(1, std::memory_order_relaxed);
+        h.size.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void init(std::size_t max_size, double aging_interval_ms) {
+        Header* h = new (base_) Header();
+        std::memcpy(h->magic, "STRVSHM", 8);
+        h->version = VERSION;
+        h->capacity = max_size;
+        h->aging_interval_ms = aging_interval_ms;
+        h->owner_pid = current_pid();
+        h->size.store(0);
+        for (auto& c : h->count) c.store(0);
+        h->next_id.store(0);
+        header_ = h;
+#ifndef _WIN32
+        pthread_mutexattr_t ma;
+        pthread_mutexattr_init(&ma);
+        pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&ma, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&h->mtx, &ma);
+        pthread_mutexattr_destroy(&ma);
+        for (auto& s : h->seq) s.store(0);
+#endif
+        open_sync();
+        h->ready.store(READY, std::memory_order_release);
+    }
+
+    void check_header() {
+        if (std::memcmp(header_->magic, "STRVSHM", 8) != 0 || header_->version != VERSION) {
+            unmap();
+            throw std::invalid_argument(name_ + " no es una cola compartida (version " +
+                std::to_string(VERSION) + ")");
+        }
+    }
+
+    // ---- Sincronización ----
+
+    class Lock {
+    public:
+        explicit Lock(SharedTaskQueue& q) : q_(q) { q_.lock(); }
+        ~Lock() { q_.unlock(); }
+    private:
+        SharedTaskQueue& q_;
+    };
+
+#ifndef _WIN32
+    void open_sync() { check_header(); }
+
+    static std::int64_t current_pid() { return (std::int64_t)getpid(); }
+
+    static bool process_alive(std::int64_t pid) {
+        return kill((pid_t)pid, 0) == 0 || errno != ESRCH;
+    }
+
+    [[noreturn]] void fail(const std::string& what) {
+        int err = errno;
+        unmap();
+        throw std::system_error(err, std::generic_category(), what + " " + name_);
+    }
+
+    void lock() {
+        if (pthread_mutex_lock(&header_->mtx) == EOWNERDEAD) {
+            // Un proceso murió con el lock tomado, quizás a mitad de una
+            // operación
+            repair_locked();
+            pthread_mutex_consistent(&header_->mtx);
+        }
+    }
+
+    void unlock() { pthread_mutex_unlock(&header_->mtx); }
+
+    // Con el lock tomado. El contador se lee antes de soltar el lock: si
+    // llega un aviso entre unlock() y la espera, futex ve el contador
+    // cambiado y vuelve enseguida
+    void wait(Cond c) {
+        std::uint32_t seen = header_->seq[c].load(std::memory_order_relaxed);
+        ++header_->waiters[c];
+        unlock();
+#ifdef __linux__
+        timespec ts{ 0, WAIT_MS * 1000000L };
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&header_->seq[c]), FUTEX_WAIT, seen, &ts, nullptr, 0);
+#else
+        (void)seen;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+        lock();
+        --header_->waiters[c];
+    }
+
+    void signal(Cond c, bool all) {
+        header_->seq[c].fetch_add(1, std::memory_order_relaxed);
+#ifdef __linux__
+        if (header_->waiters[c] > 0) {
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&header_->seq[c]), FUTEX_WAKE,
+                all ? INT_MAX : 1, nullptr, nullptr, 0);
+        }
+#else
+        (void)all;
+#endif
+    }
+
+    bool map(bool create, std::size_t bytes) {
+        std::string shmName = "/" + name_;
+        if (create) {
+            fd_ = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd_ < 0 && errno == EEXIST) {
+                if (segment_in_use(shmName)) {
+                    errno = EBUSY;
+                    fail("segmento en uso");
+                }
+                shm_unlink(shmName.c_str()); // segmento viejo de una ejecución que murió
+                fd_ = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            }
+            if (fd_ < 0 || ftruncate(fd_, (off_t)bytes) != 0) fail("no se pudo crear el segmento compartido");
+            owner_ = true;
+            bytes_ = bytes;
+        }
+        else {
+            fd_ = shm_open(shmName.c_str(), O_RDWR, 0600);
+            if (fd_ < 0) return false;
+            struct stat st{};
+            if (fstat(fd_, &st) != 0 || (std::size_t)st.st_size < sizeof(Header)) {
+                // Recién creado, todavía sin tamaño: reintentar
+                ::close(fd_);
+                fd_ = -1;
+                return false;
+            }
+            bytes_ = (std::size_t)st.st_size;
+        }
+        void* p = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) fail("no se pudo mapear el segmento compartido");
+        base_ = p;
+        header_ = static_cast<Header*>(p);
+        return true;
+    }
+
+    // Un segmento existente está en uso si tiene una cola de esta versión
+    // cuyo creador sigue vivo. Si todavía no está inicializado se espera un
+    // poco por si otro proceso lo está creando en este momento.
+    static bool segment_in_use(const std::string& shmName) {
+        int fd = shm_open(shmName.c_str(), O_RDONLY, 0600);
+        if (fd < 0) return false;
+        bool inUse = false;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        for (;;) {
+            struct stat st{};
+            if (fstat(fd, &st) == 0 && (std::size_t)st.st_size >= sizeof(Header)) {
+                void* p = mmap(nullptr, sizeof(Header), PROT_READ, MAP_SHARED, fd, 0);
+                if (p != MAP_FAILED) {
+                    const Header* h = static_cast<const Header*>(p);
+                    bool ready = h->ready.load(std::memory_order_acquire) == READY;
+                    if (std::memcmp(h->magic, "STRVSHM", 8) == 0 && h->version == VERSION && ready) {
+                        inUse = process_alive(h->owner_pid);
+                    }
+                    munmap(p, sizeof(Header));
+                    if (ready) break;
+                }
+            }
+            if (std::chrono::steady_clock::now() >= deadline) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        ::close(fd);
+        return inUse;
+    }
+
+    void unmap() {
+        if (base_) munmap(base_, bytes_);
+        if (fd_ >= 0) ::close(fd_);
+        if (owner_) shm_unlink(("/" + name_).c_str());
+        base_ = nullptr;
+        header_ = nullptr;
+        fd_ = -1;
+        owner_ = false;
+    }
+
+    int fd_ = -1;
+#else
+    void open_sync() {
+        check_header();
+        mutex_ = CreateMutexA(nullptr, FALSE, object_name("mtx").c_str());
+        for (int c = 0; c < NUM_CONDS; ++c) {
+            sems_[c] = CreateSemaphoreA(nullptr, 0, LONG_MAX, object_name(c == NOT_EMPTY ? "not_empty" : "not_full").c_str());
+        }
+        if (!mutex_ || !sems_[NOT_EMPTY] || !sems_[NOT_FULL]) fail("no se pudo abrir la sincronizacion de");
+    }
+
+    static std::int64_t current_pid() { return (std::int64_t)GetCurrentProcessId(); }
+
+    static bool process_alive(std::int64_t pid) {
+        HANDLE h = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)pid);
+        if (!h) return GetLastError() == ERROR_ACCESS_DENIED; // existe, pero es de otro usuario
+        bool alive = WaitForSingleObject(h, 0) == WAIT_TIMEOUT;
+        CloseHandle(h);
+        return alive;
+    }
+
+    [[noreturn]] void fail(const std::string& what) {
+        DWORD err = GetLastError();
+        unmap();
+        throw std::system_error((int)err, std::system_category(), what + " " + name_);
+    }
+
+    std::string object_name(const char* what) const { return "Local\\" + name_ + "." + what; }
+
+    void lock() {
+        // WAIT_ABANDONED: el dueño murió, quizás a mitad de una operación;
+        // el lock pasa a este hilo igual
+        if (WaitForSingleObject(mutex_, INFINITE) == WAIT_ABANDONED) repair_locked();
+    }
+
+    void unlock() { ReleaseMutex(mutex_); }
+
+    // Con el lock tomado. Soltar el mutex y esperar no es atómico: un
+    // aviso entre ambos deja una ficha en el semáforo (despertar de más,
+    // inofensivo) y uno perdido lo cubre el tope de la espera.
+    void wait(Cond c) {
+        ++header_->waiters[c];
+        unlock();
+        WaitForSingleObject(sems_[c], (DWORD)WAIT_MS);
+        lock();
+        --header_->waiters[c];
+    }
+
+    void signal(Cond c, bool all) {
+        long n = header_->waiters[c];
+        if (n > 0) ReleaseSemaphore(sems_[c], all ? n : 1, nullptr);
+    }
+
+    bool map(bool create, std::size_t bytes) {
+        std::string mapName = object_name("shm");
+        if (create) {
+            mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                (DWORD)((unsigned long long)bytes >> 32), (DWORD)(bytes & 0xFFFFFFFFull), mapName.c_str());
+            if (!mapping_) fail("no se pudo crear el segmento compartido");
+            // El mapeo existe mientras algún proceso lo tenga abierto, así
+            // que si ya existía es de una cola viva
+            if (GetLastError() == ERROR_ALREADY_EXISTS) fail("segmento en uso");
+            owner_ = true;
+        }
+        else {
+            mapping_ = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mapName.c_str());
+            if (!mapping_) return false;
+        }
+        base_ = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        if (!base_) fail("no se pudo mapear el segmento compartido");
+        header_ = static_cast<Header*>(base_);
+        return true;
+    }
+
+    // El sistema borra el mapeo y los objetos al cerrarse el último handle
+    void unmap() {
+        if (base_) UnmapViewOfFile(base_);
+        if (mapping_) CloseHandle(mapping_);
+        if (mutex_) CloseHandle(mutex_);
+        for (HANDLE& s : sems_) {
+            if (s) CloseHandle(s);
+            s = nullptr;
+        }
+        base_ = nullptr;
+        header_ = nullptr;
+        mapping_ = nullptr;
+        mutex_ = nullptr;
+        owner_ = false;
+    }
+
+    HANDLE mapping_ = nullptr;
+    HANDLE mutex_ = nullptr;
+    HANDLE sems_[NUM_CONDS] = { nullptr, nullptr };
+#endif
+
+    std::string name_;
+    bool owner_ = false;
+    void* base_ = nullptr;
+    std::size_t bytes_ = 0;
+    Header* header_ = nullptr;
+};
@@ -0,0 +1,66 @@
+// snapshot.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "task.h"
+
+// Contadores de la cola que lee el monitor
+struct QueueSnapshot {
+    long long pending[NUM_CLASSES]; // tareas en cola por clase (A, M, B)
+    long long enqueued;             // total insertadas desde run()
+    long long dequeued;             // total extraídas desde run()
+};
+
+// Seqlock: publica un valor trivialmente copiable para lectores que nunca
+// bloquean al escritor. Solo puede haber un escritor a la vez (en la
+// simulación, el hilo que tiene tomado mtx_); los lectores reintentan si su
+// copia se cruzó con una escritura. El valor se guarda en palabras atómicas
+// para que la lectura concurrente no sea una carrera de datos.
+template <class T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock requiere un tipo trivialmente copiable");
+    static constexpr std::size_t WORDS = (sizeof(T) + 7) / 8;
+
+public:
+    SeqLock() {
+        store(T{});
+    }
+
+    void store(const T& value) {
+        std::uint64_t buf[WORDS] = {};
+        std::memcpy(buf, &value, sizeof(T));
+
+        std::uint64_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed); // impar: escritura en curso
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            data_[i].store(buf[i], std::memory_order_relaxed);
+        }
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    T load() const {
+        std::uint64_t buf[WORDS];
+        std::uint64_t s0, s1;
+        do {
+            s0 = seq_.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < WORDS; ++i) {
+                buf[i] = data_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s1 = seq_.load(std::memory_order_relaxed);
+        } while ((s0 & 1) || s0 != s1);
+
+        T value;
+        std::memcpy(&value, buf, sizeof(T));
+        return value;
+    }
+
+private:
+    std::atomic<std::uint64_t> seq_{ 0 };
+    std::atomic<std::uint64_t> data_[WORDS];
+};
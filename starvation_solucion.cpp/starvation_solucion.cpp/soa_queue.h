@@ -0,0 +1,331 @@
+// soa_queue.h
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "task.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+#define SOA_HAVE_AVX2 1
+#endif
+
+// Cola para políticas cuyo puntaje no se puede ordenar por clase.
+//
+// Con aging por clase la más antigua de cada clase es siempre la mejor
+// (ver AgingQueue) y alcanza con mirar 3 cabezas. Si cada tarea trae su
+// propio peso eso deja de valer: hay que puntuar todas las tareas en
+// cada extracción. Para que ese recorrido sea barato la cola guarda los
+// datos del puntaje en arreglos separados (struct of arrays), contiguos y
+// sin Task de por medio:
+//
+//   base_[i]    prioridad base de la clase
+//   slope_[i]   peso de la tarea / aging_interval_ms
+//   tick_[i]    llegada en ms enteros desde el origen de la cola
+//   id_[i]      para desempatar
+//
+//   puntaje_i = base_i + slope_i * (ahora - tick_i)
+//
+// y lo recorre con AVX2 (8 tareas por instrucción) si la CPU lo tiene, o
+// con un bucle escalar si no. En empate gana la más antigua (menor id),
+// igual que en las demás colas. Extraer mueve la última tarea al hueco:
+// O(1) además del recorrido.
+enum class ScoreKernel { Scalar, Simd };
+
+namespace soa_detail {
+
+struct Best {
+    std::size_t index;
+    float score;
+    std::int32_t id;
+};
+
+// Mismo orden de operaciones que la versión SIMD (sin FMA): los
+// resultados son idénticos bit a bit
+inline float score(float base, float slope, std::int32_t tick, std::int32_t now) {
+    return base + slope * (float)(now - tick);
+}
+
+inline Best argmax_scalar(const float* base, const float* slope, const std::int32_t* tick,
+    const std::int32_t* id, std::size_t begin, std::size_t n, std::int32_t now,
+    Best best = { 0, -std::numeric_limits<float>::infinity(), INT_MAX }) {
+    for (std::size_t i = begin; i < n; ++i) {
+        float s = score(base[i], slope[i], tick[i], now);
+        if (s > best.score || (s == best.score && id[i] < best.id)) best = { i, s, id[i] };
+    }
+    return best;
+}
+
+#ifdef SOA_HAVE_AVX2
+inline bool cpu_has_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return IsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// Cada carril lleva su mejor (puntaje, id, índice). Se recorren 16 tareas
+// por vuelta con dos juegos de carriles independientes, para no esperar
+// la latencia de la comparación anterior; al final se combinan, se
+// reducen los 8 carriles y se sigue escalar con el resto.
+struct LanesAvx2 {
+    __m256 score;
+    __m256i id;
+    __m256i index;
+};
+
+#if !defined(_MSC_VER) || defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+inline void keep_best_avx2(LanesAvx2& best, __m256 s, __m256i ids, __m256i idx) {
+    __m256 gt = _mm256_cmp_ps(s, best.score, _CMP_GT_OQ);
+    __m256 eq = _mm256_cmp_ps(s, best.score, _CMP_EQ_OQ);
+    __m256 older = _mm256_castsi256_ps(_mm256_cmpgt_epi32(best.id, ids));
+    __m256 take = _mm256_or_ps(gt, _mm256_and_ps(eq, older));
+    best.score = _mm256_blendv_ps(best.score, s, take);
+    best.id = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(best.id), _mm256_castsi256_ps(ids), take));
+    best.index = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(best.index), _mm256_castsi256_ps(idx), take));
+}
+
+#if !defined(_MSC_VER) || defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+inline __m256 score_avx2(const float* base, const float* slope, const std::int32_t* tick,
+    std::size_t i, __m256i nowv) {
+    __m256 wait = _mm256_cvtepi32_ps(_mm256_sub_epi32(nowv,
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tick + i))));
+    return _mm256_add_ps(_mm256_loadu_ps(base + i), _mm256_mul_ps(_mm256_loadu_ps(slope + i), wait));
+}
+
+#if !defined(_MSC_VER) || defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+inline Best argmax_avx2(const float* base, const float* slope, const std::int32_t* tick,
+    const std::int32_t* id, std::size_t n, std::int32_t now) {
+    const __m256i nowv = _mm256_set1_epi32(now);
+    const __m256i sixteen = _mm256_set1_epi32(16);
+    LanesAvx2 a{ _mm256_set1_ps(-std::numeric_limits<float>::infinity()),
+        _mm256_set1_epi32(INT_MAX), _mm256_setzero_si256() };
+    LanesAvx2 b = a;
+    __m256i idxA = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i idxB = _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15);
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        keep_best_avx2(a, score_avx2(base, slope, tick, i, nowv),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(id + i)), idxA);
+        keep_best_avx2(b, score_avx2(base, slope, tick, i + 8, nowv),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(id + i + 8)), idxB);
+        idxA = _mm256_add_epi32(idxA, sixteen);
+        idxB = _mm256_add_epi32(idxB, sixteen);
+    }
+    keep_best_avx2(a, b.score, b.id, b.index);
+
+    alignas(32) float laneS[8];
+    alignas(32) std::int32_t laneId[8];
+    alignas(32) std::int32_t laneIdx[8];
+    _mm256_store_ps(laneS, a.score);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneId), a.id);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneIdx), a.index);
+
+    Best best = { 0, -std::numeric_limits<float>::infinity(), INT_MAX };
+    for (int l = 0; l < 8; ++l) {
+        if (laneId[l] == INT_MAX) continue; // carril sin tareas
+        if (laneS[l] > best.score || (laneS[l] == best.score && laneId[l] < best.id)) {
+            best = { (std::size_t)laneIdx[l], laneS[l], laneId[l] };
+        }
+    }
+    return argmax_scalar(base, slope, tick, id, i, n, now, best);
+}
+#endif
+
+} // namespace soa_detail
+
+// Aging con peso por tarea (Task::weight) sobre la cola SoA
+class WeightedAgingQueue {
+public:
+    static constexpr const char* NAME = "weighted";
+
+    explicit WeightedAgingQueue(const PolicyParams& p = PolicyParams())
+        : inv_interval_((float)(1.0 / p.aging_interval_ms)) {
+    }
+
+    // true si pop_next usa AVX2 en esta CPU
+    static bool simd_available() {
+#ifdef SOA_HAVE_AVX2
+        static const bool has = soa_detail::cpu_has_avx2();
+        return has;
+#else
+        return false;
+#endif
+    }
+
+    void push(const Task& t) {
+        if (tasks_.empty() && !has_origin_) {
+            origin_ = t.enqueue_time;
+            has_origin_ = true;
+        }
+        tasks_.push_back(t);
+        base_.push_back((float)base_priority(t.type));
+        slope_.push_back(t.weight * inv_interval_);
+        tick_.push_back(tick_of(t.enqueue_time));
+        id_.push_back(t.id);
+        ++counts_[class_index(t.type)];
+    }
+
+    bool empty() const { return tasks_.empty(); }
+    std::size_t size() const { return tasks_.size(); }
+    std::size_t count(char type) const { return counts_[class_index(type)]; }
+
+    void clear() {
+        tasks_.clear();
+        base_.clear();
+        slope_.clear();
+        tick_.clear();
+        id_.clear();
+        counts_ = {};
+        has_origin_ = false;
+    }
+
+    // Tarea de mayor puntaje en 'now' sin sacarla. Precondición: !empty()
+    const Task& peek(std::chrono::steady_clock::time_point now,
+        ScoreKernel kernel = ScoreKernel::Simd) const {
+        return tasks_[best_index(now, kernel)];
+    }
+
+    // Precondición: !empty()
+    Task pop_next(std::chrono::steady_clock::time_point now) {
+        return remove_at(best_index(now, ScoreKernel::Simd));
+    }
+
+    // La más antigua de la clase (descarte por sobrecarga), O(n)
+    Task evict_oldest(std::size_t cls) {
+        std::size_t best = tasks_.size();
+        for (std::size_t i = 0; i < tasks_.size(); ++i) {
+            if (class_index(tasks_[i].type) == cls && (best == tasks_.size() || id_[i] < id_[best])) best = i;
+        }
+        return remove_at(best);
+    }
+
+    // Tarea vencida o cancelada, O(n) sobre los ids
+    bool erase(std::size_t, int id) {
+        auto it = std::find(id_.begin(), id_.end(), id);
+        if (it == id_.end()) return false;
+        remove_at((std::size_t)(it - id_.begin()));
+        return true;
+    }
+
+    // En orden de llegada (por id); solo lo usa el monitor, O(n log n)
+    template <class F>
+    void for_each(F f) const {
+        std::vector<std::size_t> order(tasks_.size());
+        std::iota(order.begin(), order.end(), std::size_t(0));
+        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return id_[a] < id_[b]; });
+        for (std::size_t i : order) f(tasks_[i]);
+    }
+
+private:
+    std::int32_t tick_of(std::chrono::steady_clock::time_point tp) const {
+        return (std::int32_t)std::chrono::duration_cast<std::chrono::milliseconds>(tp - origin_).count();
+    }
+
+    std::size_t best_index(std::chrono::steady_clock::time_point now, ScoreKernel kernel) const {
+        std::int32_t nowTick = tick_of(now);
+#ifdef SOA_HAVE_AVX2
+        if (kernel == ScoreKernel::Simd && simd_available()) {
+            return soa_detail::argmax_avx2(base_.data(), slope_.data(), tick_.data(), id_.data(),
+                tasks_.size(), nowTick).index;
+        }
+#endif
+        (void)kernel;
+        return soa_detail::argmax_scalar(base_.data(), slope_.data(), tick_.data(), id_.data(),
+            0, tasks_.size(), nowTick).index;
+    }
+
+    // Saca la tarea i y mueve la última a su lugar
+    Task remove_at(std::size_t i) {
+        Task t = tasks_[i];
+        std::size_t last = tasks_.size() - 1;
+        if (i != last) {
+            tasks_[i] = tasks_[last];
+            base_[i] = base_[last];
+            slope_[i] = slope_[last];
+            tick_[i] = tick_[last];
+            id_[i] = id_[last];
+        }
+        tasks_.pop_back();
+        base_.pop_back();
+        slope_.pop_back();
+        tick_.pop_back();
+        id_.pop_back();
+        --counts_[class_index(t.type)];
+        if (tasks_.empty()) has_origin_ = false;
+        return t;
+    }
+
+    float inv_interval_;
+    std::chrono::steady_clock::time_point origin_{};
+    bool has_origin_ = false;
+
+    std::vector<Task> tasks_;
+    std::vector<float> base_;
+    std::vector<float> slope_;
+    std::vector<std::int32_t> tick_;
+    std::vector<std::int32_t> id_;
+    std::array<std::size_t, NUM_CLASSES> counts_{};
+};
+
+// Implementación de referencia: arreglo de Task (deque) y duration_cast
+// por elemento, el recorrido que haría select_task_index_unlocked con
+// pesos. Mismo puntaje y desempate que WeightedAgingQueue; solo para el
+// benchmark.
+class LinearWeightedAgingQueue {
+public:
+    explicit LinearWeightedAgingQueue(double aging_interval_ms = 200.0)
+        : inv_interval_((float)(1.0 / aging_interval_ms)) {
+    }
+
+    // 'origin' hace de tick 0, como el origen de WeightedAgingQueue
+    void push(const Task& t, std::chrono::steady_clock::time_point origin) {
+        queue_.push_back(t);
+        origin_ = origin;
+    }
+    std::size_t size() const { return queue_.size(); }
+
+    const Task& peek(std::chrono::steady_clock::time_point now) const {
+        using namespace std::chrono;
+        auto nowTick = (std::int32_t)duration_cast<milliseconds>(now - origin_).count();
+        std::size_t best = 0;
+        float bestScore = -std::numeric_limits<float>::infinity();
+        for (std::size_t i = 0; i < queue_.size(); ++i) {
+            const Task& t = queue_[i];
+            auto tick = (std::int32_t)duration_cast<milliseconds>(t.enqueue_time - origin_).count();
+            float s = soa_detail::score((float)base_priority(t.type), t.weight * inv_interval_, tick, nowTick);
+            if (s > bestScore || (s == bestScore && t.id < queue_[best].id)) {
+                bestScore = s;
+                best = i;
+            }
+        }
+        return queue_[best];
+    }
+
+private:
+    float inv_interval_;
+    std::chrono::steady_clock::time_point origin_{};
+    std::deque<Task> queue_;
+};
@@ -11,25 +11,284 @@
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <queue>
+#include <functional>
+#include <array>
+#include <stdexcept>
+#include <system_error>
+#include <limits>
+#include <unordered_map>
+#include <span>
+#include <type_traits>
+#include <latch>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "task.h"
+#include "aging_scheduler.h"
+#include "scheduling_policies.h"
+#include "soa_queue.h"
+#include "lockfree_queue.h"
+#include "shared_queue.h"
+#include "work_stealing_queue.h"
+#include "snapshot.h"
+#include "histogram.h"
+#include "aging_controller.h"
+#include "elastic_pool.h"
+#include "thread_affinity.h"
+#include "coro_runtime.h"
+#include "arrival_trace.h"
+#include "timing_wheel.h"
+#include "workload_kernels.h"
 
 using namespace std::chrono;
 
-// Representa una tarea en la cola
-struct Task {
-    char type; // 'A', 'M', 'B'
-    int id;    // identificador único
-    steady_clock::time_point enqueue_time; // instante en que entró a la cola
+// Memoria residente del proceso en KB (-1 si la plataforma no la expone)
+inline long long resident_kb() {
+#ifndef _WIN32
+    std::ifstream statm("/proc/self/statm");
+    long long pages = 0, resident = 0;
+    if (statm >> pages >> resident) {
+        return resident * (long long)sysconf(_SC_PAGESIZE) / 1024;
+    }
+#endif
+    return -1;
+}
+
+// Backend de la cola compartida
+enum class QueueBackend {
+    MutexDeque,   // mutex + variables de condición (original)
+    LockFreeRing, // anillos MPMC sin locks, ver lockfree_queue.h
+    WorkStealing, // una cola por consumidor con robo, ver work_stealing_queue.h
+    SharedMemory  // segmento compartido entre procesos, ver shared_queue.h
+};
+
+// Qué parte de la simulación corre este proceso con el backend
+// SharedMemory
+enum class ShmRole {
+    Both,     // productores y consumidores aquí, a través del segmento
+    Producer, // solo productores: se conecta al segmento de un consumidor
+    Consumer  // solo consumidores: crea el segmento y atiende a los productores
+};
+
+// Qué hace un productor cuando la cola está llena
+enum class OverflowPolicy {
+    Block,            // esperar lugar sin límite (original)
+    DropNewest,       // rechazar la tarea nueva
+    DropOldestLowest, // descartar la más antigua de la clase más baja en cola
+    RejectByClass     // admitir cada clase solo hasta admit_pct de MAX_QUEUE
+};
+
+// Política de planificación de la cola (ver scheduling_policies.h). Es un
+// parámetro de plantilla de BasicSimulation; este enum solo sirve para
+// elegirla desde la línea de comandos (with_policy).
+enum class SchedPolicy {
+    Strict,           // A > M > B, con starvation
+    Aging,            // prioridad con aging (la solución original)
+    WeightedFair,     // WFQ según share
+    DeficitRoundRobin,
+    EarliestDeadline,
+    WeightedAging     // aging con peso por tarea (soa_queue.h)
+};
+
+// Parámetros de una ejecución. Los valores por defecto reproducen la
+// simulación original (5 productores, 3 consumidores, 10 s).
+struct SimConfig {
+    QueueBackend backend = QueueBackend::MutexDeque;
+    int num_producers = 5;
+    int num_consumers = 3;
+    size_t max_queue = 20;
+    int run_ms = 10000;
+    std::array<int, NUM_CLASSES> weights{ 10, 30, 60 };         // distribución A, M, B
+    std::array<int, NUM_CLASSES> processing_ms{ 50, 100, 150 }; // servicio A, M, B
+    double aging_interval_ms = 200.0;
+    double weight_spread = 0.5;      // peso de aging por tarea en [1 - s, 1 + s] (política weighted)
+    SchedPolicy policy = SchedPolicy::Aging;
+    std::array<int, NUM_CLASSES> share{ 3, 2, 1 };              // pesos de WFQ y DRR
+    std::array<int, NUM_CLASSES> deadline_ms{ 250, 500, 1000 }; // plazos de EDF
+    bool adaptive_aging = false;     // ajustar aging_interval_ms en ejecución
+    AgingController::Params aging_control; // objetivos y ventana del ajuste
+    int burst_period_ms = 0;         // ráfagas: período (0 = carga pareja)
+    int burst_ms = 0;                // ráfagas: duración al inicio de cada período
+    int quiet_interval_ms = 300;     // pausa entre producciones fuera de la ráfaga
+    bool elastic = false;            // grupo de consumidores elástico (num_consumers = tamaño inicial)
+    PoolScaler::Params pool;         // límites y umbrales del grupo elástico
+    int scale_interval_ms = 100;     // período del escalador
+    OverflowPolicy overflow = OverflowPolicy::Block;
+    int enqueue_timeout_ms = 0;      // espera máxima antes de descartar (0 = no esperar)
+    std::array<int, NUM_CLASSES> admit_pct{ 100, 90, 60 }; // RejectByClass: ocupación máxima por clase
+    Placement placement = Placement::None; // fijar productores y consumidores a núcleos o nodos
+    std::vector<int> cpus;           // CPUs a usar (vacío = todas las del proceso)
+    bool node_shards = false;        // work-stealing: tareas en shards del nodo del productor
+    bool coroutines = false;         // productores y consumidores como corrutinas, ver run_coroutines()
+    int coro_workers = 0;            // hilos que ejecutan las corrutinas (0 = uno por CPU)
+    bool fixed_sequence = true;      // el productor 0 empieza con las 30 tareas fijas
+    std::string record_trace;        // grabar las llegadas en esta traza binaria (vacío = no)
+    std::string replay_trace;        // reproducir las llegadas de esta traza en lugar de producir
+    double replay_speed = 1.0;       // aceleración de la reproducción (0 = sin pausas)
+    std::array<int, NUM_CLASSES> ttl_ms{ 0, 0, 0 }; // plazo de cada tarea desde que entra (0 = sin plazo)
+    bool evict_expired = true;       // false: los plazos solo se miden, las vencidas se procesan igual
+    int cancel_pct = 0;              // % de producciones tras las que se cancela una tarea reciente
+    int expiry_tick_ms = 10;         // resolución de la rueda de plazos
+    Workload workload = Workload::Sleep; // procesar durmiendo o con trabajo de CPU calibrado
+    std::string shm_name = "starvation_cola"; // nombre del segmento (backend SharedMemory)
+    ShmRole shm_role = ShmRole::Both;
+    int shm_producers = 1;           // rol consumidor: procesos productores a esperar
+    int produce_interval_ms = 5;     // 0 = producir sin pausa (no con reloj virtual)
+    bool simulate_processing = true; // false = no dormir al procesar
+    bool verbose = true;             // monitor y resumen final
+    int producer_batch = 1;          // tareas por toma del lock al producir
+    int consumer_batch = 1;          // tareas por toma del lock al consumir
+    int monitor_interval_ms = 2000;  // período de la tabla del monitor
+    int dump_queue_every = 1;        // volcar la cola cada N ticks (0 = nunca)
+    std::string latency_csv;         // exportar percentiles a este CSV (vacío = no)
+    bool virtual_clock = false;      // simulación de eventos discretos, ver run_virtual()
+    unsigned seed = 42;              // semilla de los productores en modo virtual
+
+    PolicyParams policy_params() const {
+        PolicyParams p;
+        p.aging_interval_ms = aging_interval_ms;
+        p.share = share;
+        p.cost_ms = processing_ms;
+        p.deadline_ms = deadline_ms;
+        return p;
+    }
+
+    bool has_deadlines() const { return ttl_ms[0] > 0 || ttl_ms[1] > 0 || ttl_ms[2] > 0; }
+    bool evicts_expired() const { return evict_expired && has_deadlines(); }
+
+    // Plazos que se vencen o cancelaciones: la cola lleva un índice por id
+    bool tracks_tasks() const { return evicts_expired() || cancel_pct > 0; }
 };
 
-class Simulation {
+// Simulación parametrizada por la política de planificación de la cola
+// (una de scheduling_policies.h). La política se resuelve en compilación:
+// pop_next() se llama directamente, sin despacho virtual.
+template <class Policy = AgingQueue>
+class BasicSimulation {
 public:
-    Simulation()
-        : MAX_QUEUE(20),
-        RUN_SECONDS(10),
-        next_id(0)
+    explicit BasicSimulation(const SimConfig& cfg = SimConfig())
+        : MAX_QUEUE(cfg.max_queue),
+        cfg_(cfg),
+        queue_(cfg.policy_params()),
+        next_id(0),
+        scaler_(cfg.pool),
+        affinity_(cfg.placement, CpuTopology::detect(cfg.cpus)),
+        expiry_wheel_(1024, cfg.expiry_tick_ms * 1000LL)
     {
-        // Secuencia fija de las primeras 30 tareas
-        initial_sequence = {
+        if (cfg_.elastic && (cfg_.pool.min_size < 1 || cfg_.pool.max_size < cfg_.pool.min_size)) {
+            throw std::invalid_argument("grupo elastico: se requiere 1 <= min <= max");
+        }
+
+        // Los backends sin lock y con robo tienen el aging incorporado
+        if (cfg_.backend != QueueBackend::MutexDeque && !IS_AGING) {
+            throw std::invalid_argument(std::string("la politica ") + Policy::NAME +
+                " solo esta disponible con el backend mutex");
+        }
+
+        if (cfg_.backend != QueueBackend::MutexDeque && cfg_.overflow != OverflowPolicy::Block &&
+            (cfg_.overflow == OverflowPolicy::DropOldestLowest || cfg_.enqueue_timeout_ms > 0)) {
+            throw std::invalid_argument("descartar la mas antigua o esperar con plazo requiere el backend mutex");
+        }
+
+        if (cfg_.adaptive_aging) {
+            if (cfg_.backend != QueueBackend::MutexDeque || !IS_AGING) {
+                throw std::invalid_argument("el aging adaptativo requiere la politica aging y el backend mutex");
+            }
+            aging_ctl_ = std::make_unique<AgingController>(cfg_.aging_interval_ms, cfg_.aging_control);
+        }
+
+        if (cfg_.coroutines && (cfg_.backend != QueueBackend::MutexDeque || cfg_.elastic || cfg_.virtual_clock)) {
+            throw std::invalid_argument("el modo corrutinas requiere el backend mutex, sin grupo elastico ni reloj virtual");
+        }
+
+        if (!cfg_.replay_trace.empty()) {
+            if (cfg_.coroutines) {
+                throw std::invalid_argument("la reproduccion de trazas no esta disponible en modo corrutinas");
+            }
+            if (cfg_.replay_trace == cfg_.record_trace) {
+                throw std::invalid_argument("no se puede grabar sobre la traza que se reproduce");
+            }
+            if (cfg_.replay_speed < 0) {
+                throw std::invalid_argument("replay-speed: debe ser >= 0");
+            }
+            trace_ = std::make_unique<TraceReader>(cfg_.replay_trace);
+        }
+
+        if (cfg_.tracks_tasks() && (cfg_.backend != QueueBackend::MutexDeque || cfg_.coroutines)) {
+            throw std::invalid_argument("los plazos y las cancelaciones requieren el backend mutex (sin corrutinas)");
+        }
+
+        if (cfg_.workload != Workload::Sleep && cfg_.simulate_processing) {
+            if (cfg_.virtual_clock) {
+                throw std::invalid_argument("el reloj virtual no ejecuta trabajo de CPU (workload=sleep)");
+            }
+            kernel_ = std::make_unique<WorkloadKernel>(cfg_.workload);
+            kernel_->calibrate();
+        }
+
+        if (cfg_.node_shards && cfg_.backend != QueueBackend::WorkStealing) {
+            throw std::invalid_argument("los shards por nodo requieren el backend work-stealing");
+        }
+        // El nodo de cada shard es el de su consumidor (node_for), que solo
+        // corre ahí si se lo fija
+        if (cfg_.node_shards && cfg_.placement == Placement::None) {
+            throw std::invalid_argument("los shards por nodo requieren --pin=node o --pin=core");
+        }
+
+        // run_virtual() solo maneja queue_ (push_unlocked / pop_live_unlocked)
+        if (cfg_.virtual_clock && cfg_.backend != QueueBackend::MutexDeque) {
+            throw std::invalid_argument("el reloj virtual requiere el backend mutex");
+        }
+        // Sin pausa entre producciones el reloj virtual no avanza: cada
+        // Produce programa el siguiente en el mismo instante y nunca se
+        // llega a run_ms (la reproducción de trazas termina con la traza)
+        if (cfg_.virtual_clock && cfg_.replay_trace.empty() &&
+            (cfg_.produce_interval_ms <= 0 || (cfg_.burst_period_ms > 0 && cfg_.quiet_interval_ms <= 0))) {
+            throw std::invalid_argument("el reloj virtual requiere interval-ms > 0 (y quiet-interval-ms > 0 con rafagas)");
+        }
+
+        if (cfg_.shm_role != ShmRole::Both && cfg_.backend != QueueBackend::SharedMemory) {
+            throw std::invalid_argument("shm-role requiere el backend shm");
+        }
+        if (cfg_.backend == QueueBackend::SharedMemory && cfg_.elastic) {
+            throw std::invalid_argument("el backend shm no admite grupo elastico");
+        }
+        if (cfg_.shm_role == ShmRole::Consumer && trace_) {
+            throw std::invalid_argument("la traza se reproduce en el proceso productor");
+        }
+
+        if (cfg_.backend == QueueBackend::LockFreeRing) {
+            lf_queue_ = std::make_unique<LockFreeTaskQueue>(MAX_QUEUE, cfg_.aging_interval_ms);
+        }
+        else if (cfg_.backend == QueueBackend::WorkStealing) {
+            // El shard i es del consumidor i, que corre en affinity_.node_for(i)
+            std::vector<int> shardNode;
+            if (cfg_.node_shards) {
+                for (int i = 0; i < consumer_threads(); ++i) shardNode.push_back((int)affinity_.node_for(i));
+            }
+            ws_queue_ = std::make_unique<WorkStealingQueues>(
+                (size_t)consumer_threads(), MAX_QUEUE, cfg_.aging_interval_ms, shardNode);
+        }
+        else if (cfg_.backend == QueueBackend::SharedMemory) {
+            // El consumidor crea el segmento (capacidad y aging son los suyos)
+            // y los productores se conectan y se anuncian
+            if (cfg_.shm_role == ShmRole::Producer) {
+                shm_queue_ = SharedTaskQueue::open(cfg_.shm_name);
+                shm_queue_->attach_producer();
+            }
+            else shm_queue_ = SharedTaskQueue::create(cfg_.shm_name, MAX_QUEUE, cfg_.aging_interval_ms);
+        }
+
+        // Secuencia fija de las primeras 30 tareas (vacía si se desactivó)
+        if (cfg_.fixed_sequence) initial_sequence = {
             // 1-10
             'B','B','M','B','B','B','A','M','B','B',
             // 11-20
@@ -40,40 +299,69 @@ public:
     }
 
     void run() {
-        // Resetear estado compartido
-        {
-            std::lock_guard<std::mutex> lk(mtx_);
-            queue_.clear();
+        if (cfg_.virtual_clock) {
+            run_virtual();
+            return;
+        }
+        if (cfg_.coroutines) {
+            run_coroutines();
+            return;
         }
 
-        processedA = 0;
-        processedM = 0;
-        processedB = 0;
+        reset_state();
+        auto start = steady_clock::now();
 
-        stop_production = false;
-        stop_consumers = false;
-        initial_done = false;
-        next_id = 0;
+        // Todos los hilos esperan en el latch hasta que estén creados
+        const int workers = consumer_threads() + producer_threads() +
+            (cfg_.verbose ? 1 : 0) + (cfg_.elastic ? 1 : 0) + (cfg_.evicts_expired() ? 1 : 0);
+        start_latch_ = std::make_unique<std::latch>(workers + 1);
 
         // Lanzar hilos
         std::vector<std::thread> producers;
         std::vector<std::thread> consumers;
 
-        for (int i = 0; i < 3; ++i) {
-            consumers.emplace_back(&Simulation::consumer, this, i);
+        for (int i = 0; i < consumer_threads(); ++i) {
+            consumers.emplace_back(&BasicSimulation::consumer, this, i);
+        }
+        if (trace_) {
+            producers.emplace_back(&BasicSimulation::replay_producer, this);
+        }
+        else {
+            for (int i = 0; i < producer_threads(); ++i) {
+                producers.emplace_back(&BasicSimulation::producer, this, i);
+            }
+        }
+        std::thread monitor_thread;
+        if (cfg_.verbose) {
+            monitor_thread = std::thread(&BasicSimulation::monitor, this);
         }
-        for (int i = 0; i < 5; ++i) {
-            producers.emplace_back(&Simulation::producer, this, i);
+        std::thread scaler_thread;
+        if (cfg_.elastic) {
+            scaler_thread = std::thread(&BasicSimulation::scaler, this);
+        }
+        std::thread expirer_thread;
+        if (cfg_.evicts_expired()) {
+            expirer_thread = std::thread(&BasicSimulation::expirer, this);
         }
 
-        std::thread monitor_thread(&Simulation::monitor, this);
+        // Arrancar todos juntos; run_start_ queda visible para los hilos
+        // porque se escribe antes de llegar al latch
+        run_start_ = steady_clock::now();
+        start_latch_->arrive_and_wait();
 
-        // Dejar correr 10 segundos (para la tabla)
-        std::this_thread::sleep_for(std::chrono::seconds(RUN_SECONDS));
+        // Dejar correr 10 segundos (para la tabla), o hasta que se termine
+        // de reproducir la traza
+        // Si los productores remotos no terminaron a tiempo, siguen
+        // insertando: no se espera a vaciar la cola
+        bool drain = true;
+        if (trace_) producers.front().join();
+        else if (cfg_.shm_role == ShmRole::Consumer) drain = wait_remote_producers();
+        else std::this_thread::sleep_until(run_start_ + milliseconds(cfg_.run_ms));
 
         // A los 10s: parar producción
+        resident_kb_ = resident_kb();
         stop_production = true;
-        cv_not_full_.notify_all();
+        wake_producers();
 
         // Esperar a que terminen productores
         for (auto& p : producers) {
@@ -81,260 +369,3021 @@ public:
         }
 
         // Versión SIN starvation:
-        // dejamos que los consumidores sigan hasta vaciar la cola
-        while (true) {
-            std::unique_lock<std::mutex> lk(mtx_);
-            if (queue_.empty()) break;
-            lk.unlock();
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        // dejamos que los consumidores sigan hasta vaciar la cola. El
+        // consumidor que la deja vacía avisa por drain_cv_ (notify_if_drained).
+        // Un proceso solo productor deja el vaciado al consumidor.
+        if (cfg_.shm_role == ShmRole::Producer) shm_queue_->detach_producer();
+        else if (drain) {
+            std::unique_lock<std::mutex> lk(signal_mtx_);
+            drain_cv_.wait(lk, [&] { return pending_tasks() == 0; });
         }
 
         // Ahora sí detenemos consumidores
         stop_consumers = true;
-        cv_not_empty_.notify_all();
+        wake_consumers();
         for (auto& c : consumers) {
             if (c.joinable()) c.join();
         }
 
+        {
+            std::lock_guard<std::mutex> lk(signal_mtx_);
+            stop_helpers_ = true;
+        }
+        helpers_cv_.notify_all();
         if (monitor_thread.joinable()) monitor_thread.join();
+        if (scaler_thread.joinable()) scaler_thread.join();
+        if (expirer_thread.joinable()) expirer_thread.join();
 
-        // Resumen final
-        int pendingTotal = 0;
+        elapsed_seconds_ = duration<double>(steady_clock::now() - start).count();
+        finish_run();
+    }
+
+    const LatencyHistogram& wait_histogram(char type) const { return wait_hist_[class_index(type)]; }
+    const LatencyHistogram& service_histogram(char type) const { return service_hist_[class_index(type)]; }
+
+    int processed_total() const {
+        return processedA.load() + processedM.load() + processedB.load();
+    }
+
+    int processed(char type) const {
+        if (type == 'A') return processedA.load();
+        if (type == 'M') return processedM.load();
+        return processedB.load();
+    }
+
+    // p50, p90, p99, p99.9 y máximo en ms, separados por 'sep'
+    static std::string percentile_row(const LatencyHistogram& h, const char* sep) {
+        const double qs[] = { 0.50, 0.90, 0.99, 0.999 };
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(1);
+        for (double q : qs) {
+            oss << h.percentile(q) / 1000.0 << sep;
+        }
+        oss << h.max() / 1000.0;
+        return oss.str();
+    }
+
+    // Tomas de mtx_ al insertar y extraer (solo backend MutexDeque).
+    // Leer después de run().
+    long long lock_acquisitions() const { return lock_acquisitions_; }
+
+    // Intervalo de aging al terminar la última ejecución y el rango que
+    // recorrió (con aging adaptativo; si no, el configurado)
+    double aging_interval_ms() const { return aging_ctl_ ? aging_ctl_->interval_ms() : cfg_.aging_interval_ms; }
+    std::pair<double, double> aging_interval_range() const {
+        if (!aging_ctl_) return { cfg_.aging_interval_ms, cfg_.aging_interval_ms };
+        return { aging_ctl_->min_interval_seen(), aging_ctl_->max_interval_seen() };
+    }
+
+    // Consumidores activos promediados en el tiempo (grupo elástico; si no,
+    // el número fijo)
+    double average_consumers() const {
+        return pool_ms_sum_ > 0 ? active_ms_sum_ / pool_ms_sum_ : (double)initial_consumers();
+    }
+    int pool_resizes() const { return resizes_; }
+
+    long long rejected(char type) const { return rejected_[class_index(type)].load(); }
+    long long shed(char type) const { return shed_[class_index(type)].load(); }
+
+    // Tareas que vencieron en cola, que se cancelaron y que empezaron a
+    // procesarse con el plazo ya vencido (solo sin desalojo)
+    long long expired(char type) const { return expired_[class_index(type)].load(); }
+    long long cancelled(char type) const { return cancelled_[class_index(type)].load(); }
+    long long late(char type) const { return late_[class_index(type)].load(); }
+
+    // Cancela la tarea 'id' si todavía está en cola (no la que ya se está
+    // procesando). Requiere cfg.tracks_tasks(); si no, siempre false.
+    bool cancel(int id) {
+        bool empty;
         {
             std::lock_guard<std::mutex> lk(mtx_);
-            pendingTotal = (int)queue_.size();
+            if (!remove_unlocked(id, cancelled_)) return false;
+            snapshot_.store(counters_);
+            empty = queue_.empty();
         }
+        cv_not_full_.notify_one();
+        notify_if_drained(empty);
+        return true;
+    }
 
-        std::cout << "\n=============================\n";
-        std::cout << "Resumen final (SIN starvation - con aging)\n";
-        std::cout << "Tareas A procesadas: " << processedA.load() << "\n";
-        std::cout << "Tareas M procesadas: " << processedM.load() << "\n";
-        std::cout << "Tareas B procesadas: " << processedB.load() << "\n";
-        std::cout << "Tareas en cola al final: " << pendingTotal << "\n";
-        std::cout << "¿Cola vacia al terminar consumidores? "
-            << (pendingTotal == 0 ? "SI" : "NO") << "\n";
-        std::cout << "=============================\n\n";
+    // Mayor cantidad de tareas en cola durante la última ejecución
+    long long max_depth() const { return max_depth_.load(); }
+
+    // Ubicación de hilos. Una tarea cruza de nodo si se consume en un nodo
+    // distinto del que la produjo; solo cuentan las tareas con ambos nodos
+    // conocidos (nunca en modo virtual).
+    const AffinityPlan& affinity() const { return affinity_; }
+    double cross_node_fraction() const {
+        long long n = node_tasks_.load();
+        return n > 0 ? (double)cross_node_tasks_.load() / (double)n : 0.0;
+    }
+    long long cross_node_tasks() const { return cross_node_tasks_.load(); }
+    long long remote_steals() const { return ws_queue_ ? ws_queue_->remote_steals() : 0; }
+    int pin_failures() const { return pin_failures_.load(); }
+
+    // Memoria residente del proceso al detener la producción (-1 si no se
+    // sabe) y pico de memoria de los marcos de corrutinas
+    long long resident_kb_at_stop() const { return resident_kb_; }
+    static long long coroutine_frame_bytes() { return CoTask::promise_type::peak_bytes.load(); }
+    static long long coroutine_frames() { return CoTask::promise_type::peak_frames.load(); }
+
+    // Duración de la última ejecución (segundos simulados en modo virtual)
+    double elapsed_seconds() const { return elapsed_seconds_; }
+
+    // Inserción sin bloquear: si no hay lugar aplica cfg_.overflow.
+    // true si la tarea nueva quedó en la cola. Los productores la usan con
+    // --enqueue-timeout-ms=0.
+    bool try_enqueue(char type) {
+        return enqueue_for(type, milliseconds(0));
+    }
+
+    // Espera a lo sumo 'timeout' a que haya lugar para la clase y, si no lo
+    // hay, aplica cfg_.overflow. El productor nunca queda bloqueado más que
+    // 'timeout'. true si la tarea nueva quedó en la cola.
+    bool enqueue_for(char type, milliseconds timeout) {
+        long long arrival = arrival_us();
+        if (lf_queue_ || ws_queue_ || shm_queue_) {
+            // Sin espera (validado en el constructor); el límite por clase
+            // se compara con un tamaño que puede estar algo desactualizado
+            size_t depth = pending_tasks();
+            Task t = make_task(type);
+            bool ok = depth < admit_limit(type) &&
+                (lf_queue_ ? lf_queue_->try_push(t) : ws_queue_ ? ws_queue_->try_push(t) : shm_queue_->try_push(t));
+            if (ok) {
+                note_depth(depth + 1);
+                record_arrival(t, arrival);
+            }
+            else ++rejected_[class_index(type)];
+            return ok;
+        }
+
+        const size_t limit = admit_limit(type);
+        std::unique_lock<std::mutex> lk(mtx_);
+        bool room = cv_not_full_.wait_for(lk, timeout, [&] {
+            ++lock_acquisitions_;
+            return stop_production.load() || queue_.size() < limit;
+            });
+
+        if (stop_production) {
+            return false;
+        }
+        if (!room && !shed_unlocked(type)) {
+            return false;
+        }
+
+        Task t = make_task(type);
+        push_unlocked(t);
+        record_arrival(t, arrival);
+        note_depth(queue_.size());
+        snapshot_.store(counters_);
+        lk.unlock();
+
+        cv_not_empty_.notify_one();
+        return true;
     }
 
 private:
     // Parámetros
     const size_t MAX_QUEUE;
-    const int RUN_SECONDS;
+    const SimConfig cfg_;
 
-    // Cola compartida
-    std::deque<Task> queue_;
+    // Cola compartida (indexada por clase, ver aging_scheduler.h)
+    Policy queue_;
     std::mutex mtx_;
     std::condition_variable cv_not_empty_;
     std::condition_variable cv_not_full_;
+    long long lock_acquisitions_ = 0; // protegido por mtx_
+
+    // Contadores incrementales de la cola (protegidos por mtx_) y su copia
+    // publicada para el monitor, que la lee sin tomar el lock.
+    QueueSnapshot counters_{};
+    SeqLock<QueueSnapshot> snapshot_;
+
+    // Backend sin locks (solo con QueueBackend::LockFreeRing)
+    std::unique_ptr<LockFreeTaskQueue> lf_queue_;
+    // Colas por consumidor (solo con QueueBackend::WorkStealing)
+    std::unique_ptr<WorkStealingQueues> ws_queue_;
+    // Segmento entre procesos (solo con QueueBackend::SharedMemory)
+    std::unique_ptr<SharedTaskQueue> shm_queue_;
 
     // Estado global
     std::atomic<bool> stop_production{ false };
     std::atomic<bool> stop_consumers{ false };
     std::atomic<bool> initial_done{ false };
 
+    // Señales de arranque y cierre (en lugar de sondear con sleep)
+    std::unique_ptr<std::latch> start_latch_; // hilos creados, se puede empezar
+    steady_clock::time_point run_start_;      // se escribe antes del latch
+    std::mutex signal_mtx_;
+    std::condition_variable drain_cv_;        // cola vacía con la producción detenida
+    std::condition_variable helpers_cv_;      // monitor y escalador deben terminar
+    bool stop_helpers_ = false;               // protegido por signal_mtx_
+
     std::atomic<int> processedA{ 0 };
     std::atomic<int> processedM{ 0 };
     std::atomic<int> processedB{ 0 };
 
+    // Latencias por clase (us): espera en cola hasta empezar a procesarse
+    // y tiempo de servicio
+    LatencyHistogram wait_hist_[NUM_CLASSES];
+    LatencyHistogram service_hist_[NUM_CLASSES];
+
     std::atomic<int> next_id;
 
     std::vector<char> initial_sequence;
 
-    // ----- Funciones auxiliares -----
-
-    int base_priority(char type) const {
-        // A > M > B
-        switch (type) {
-        case 'A': return 3;
-        case 'M': return 2;
-        case 'B': return 1;
-        }
-        return 0;
-    }
-
-    // A = 50 ms, M = 100 ms, B = 150 ms
-    int processing_time_ms(char type) const {
-        switch (type) {
-        case 'A': return 50;
-        case 'M': return 100;
-        case 'B': return 150;
-        }
-        return 100;
-    }
+    // Duración real del último run_virtual() (para el resumen)
+    double virtual_wall_ms_ = -1;
+    long long virtual_end_us_ = 0;
 
-    // Genera tipo de tarea según distribución 10% A, 30% M, 60% B
-    char random_task_type(std::mt19937& gen,
-        std::discrete_distribution<int>& dist) {
-        int idx = dist(gen); // 0 -> A, 1 -> M, 2 -> B
-        if (idx == 0) return 'A';
-        if (idx == 1) return 'M';
-        return 'B';
-    }
+    // Aging adaptativo (solo con cfg_.adaptive_aging). El controlador se
+    // usa con mtx_ tomado; aging_now_ms_ es la copia que lee el monitor.
+    std::unique_ptr<AgingController> aging_ctl_;
+    std::atomic<double> aging_now_ms_{ 0 };
 
-    // Inserción en la cola con control de capacidad
-    void enqueue_task(char type) {
-        std::unique_lock<std::mutex> lk(mtx_);
-        cv_not_full_.wait(lk, [&] {
-            return stop_production.load() || queue_.size() < MAX_QUEUE;
-            });
+    // Tareas que no entraron a la cola (rechazadas) y tareas ya encoladas
+    // que se descartaron para hacer lugar, por clase
+    std::atomic<long long> rejected_[NUM_CLASSES] = {};
+    std::atomic<long long> shed_[NUM_CLASSES] = {};
 
-        if (stop_production) {
-            return; // ya no agregamos más tareas
-        }
+    // Grupo elástico (cfg_.elastic): se lanzan pool.max_size consumidores
+    // y solo extraen los de id < active_consumers_; el resto se estaciona
+    // en pool_cv_. scaler_ y las estadísticas solo los toca el escalador.
+    std::atomic<int> active_consumers_{ 0 };
+    std::mutex pool_mtx_;
+    std::condition_variable pool_cv_;
+    PoolScaler scaler_;
+    std::atomic<long long> window_wait_us_{ 0 }; // espera de las tareas extraídas en el período
+    std::atomic<long long> window_tasks_{ 0 };
+    double active_ms_sum_ = 0;                   // consumidores activos integrados en el tiempo
+    double pool_ms_sum_ = 0;
+    int min_active_ = 0;
+    int max_active_ = 0;
+    int resizes_ = 0;
 
-        Task t;
-        t.type = type;
-        t.id = next_id++;
-        t.enqueue_time = steady_clock::now();
-        queue_.push_back(t);
+    // Métricas de la última ejecución
+    std::atomic<long long> max_depth_{ 0 };
+    double elapsed_seconds_ = 0; // reloj real o virtual según el modo
 
-        cv_not_empty_.notify_one();
-    }
+    // Afinidad de productores y consumidores, y tráfico entre nodos
+    AffinityPlan affinity_;
+    std::atomic<long long> node_tasks_{ 0 };       // tareas con nodo de origen y destino conocidos
+    std::atomic<long long> cross_node_tasks_{ 0 }; // de esas, consumidas en otro nodo
+    std::atomic<int> pin_failures_{ 0 };           // hilos que no se pudieron fijar
 
-    // Selección de tarea con aging:
-    // prioridad efectiva = base + (tiempo_espera_ms / aging_interval_ms)
-    size_t select_task_index_unlocked() {
-        if (queue_.empty()) return 0;
+    // Modo corrutinas: planificador en uso y corrutinas suspendidas
+    // esperando lugar o tareas (protegidas por mtx_)
+    struct CoWaiter;
+    CoScheduler* co_sched_ = nullptr;
+    std::deque<CoWaiter*> co_producers_;
+    std::deque<CoWaiter*> co_consumers_;
+    long long resident_kb_ = -1; // memoria residente al detener la producción
 
-        auto now = steady_clock::now();
-        const double aging_interval_ms = 200.0; // parámetro de envejecimiento
+    // Trazas de llegadas (arrival_trace.h): la que se reproduce en lugar de
+    // producir y la que se está grabando
+    std::unique_ptr<TraceReader> trace_;
+    std::unique_ptr<TraceWriter> trace_out_;
 
-        double bestScore = -1e9;
-        size_t bestIdx = 0;
+    // Plazos y cancelaciones (solo con cfg_.tracks_tasks(), protegidos por
+    // mtx_): clase de cada tarea en cola por id y rueda con los
+    // vencimientos en us desde run_start_. Las entradas de la rueda de
+    // tareas que ya salieron se ignoran al vencer.
+    std::unordered_map<int, size_t> live_ids_;
+    TimingWheel<int> expiry_wheel_;
+    std::atomic<long long> expired_[NUM_CLASSES] = {};
+    std::atomic<long long> cancelled_[NUM_CLASSES] = {};
+    std::atomic<long long> late_[NUM_CLASSES] = {};
 
-        for (size_t i = 0; i < queue_.size(); ++i) {
-            const Task& t = queue_[i];
-            int base = base_priority(t.type);
-            auto wait_ms = duration_cast<milliseconds>(now - t.enqueue_time).count();
-            double score = base + (double)wait_ms / aging_interval_ms;
+    // Trabajo de CPU en lugar de dormir (solo con cfg_.workload != Sleep);
+    // kernel_sink_ acumula los resultados para que no se eliminen
+    std::unique_ptr<WorkloadKernel> kernel_;
+    std::atomic<std::uint64_t> kernel_sink_{ 0 };
 
-            if (score > bestScore) {
-                bestScore = score;
-                bestIdx = i;
-            }
-            else if (score == bestScore) {
-                // En empate, preferimos la más antigua
-                if (t.enqueue_time < queue_[bestIdx].enqueue_time) {
-                    bestIdx = i;
-                }
-            }
+    void note_depth(size_t depth) {
+        long long d = (long long)depth;
+        long long prev = max_depth_.load(std::memory_order_relaxed);
+        while (d > prev && !max_depth_.compare_exchange_weak(prev, d, std::memory_order_relaxed)) {
+            // reintentar
         }
-        return bestIdx;
     }
 
-    // ---- Lógica de hilos ----
+    // Resetear estado compartido
+    void reset_state() {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            queue_.clear();
+            live_ids_.clear();
+            expiry_wheel_.clear();
+            counters_ = QueueSnapshot{};
+            snapshot_.store(counters_);
+        }
 
-    // Productor: productor 0 genera la secuencia fija de 30 tareas,
-    // luego todos generan con distribución probabilística.
-    void producer(int producerId) {
-        // Random engine por hilo
-        std::random_device rd;
-        std::mt19937 gen(rd() + producerId * 1000);
-        std::discrete_distribution<int> dist({ 10, 30, 60 }); // A, M, B
+        processedA = 0;
+        processedM = 0;
+        processedB = 0;
+        lock_acquisitions_ = 0;
+        for (size_t c = 0; c < NUM_CLASSES; ++c) {
+            wait_hist_[c].reset();
+            service_hist_[c].reset();
+        }
 
-        // El productor 0 genera la secuencia fija
-        if (producerId == 0) {
-            for (char type : initial_sequence) {
-                if (stop_production) break;
-                enqueue_task(type);
-                std::this_thread::sleep_for(std::chrono::milliseconds(5));
-            }
-            initial_done = true;
+        stop_production = false;
+        stop_consumers = false;
+        initial_done = false;
+        stop_helpers_ = false;
+        if (aging_ctl_) {
+            aging_ctl_->reset(cfg_.aging_interval_ms);
+            if constexpr (IS_AGING) queue_.set_aging_interval(aging_ctl_->interval_ms());
         }
-        else {
-            // Los demás esperan hasta que la secuencia fija haya terminado
-            while (!initial_done && !stop_production) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            }
+        aging_now_ms_ = cfg_.aging_interval_ms;
+        active_consumers_ = initial_consumers();
+        scaler_.reset();
+        window_wait_us_ = 0;
+        window_tasks_ = 0;
+        active_ms_sum_ = pool_ms_sum_ = 0;
+        min_active_ = max_active_ = initial_consumers();
+        resizes_ = 0;
+        for (size_t c = 0; c < NUM_CLASSES; ++c) {
+            rejected_[c] = 0;
+            shed_[c] = 0;
+            expired_[c] = 0;
+            cancelled_[c] = 0;
+            late_[c] = 0;
         }
-
-        // Después de la secuencia fija, todos producen con la distribución dada
-        while (!stop_production) {
-            char t = random_task_type(gen, dist);
-            enqueue_task(t);
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        next_id = 0;
+        max_depth_ = 0;
+        node_tasks_ = 0;
+        cross_node_tasks_ = 0;
+        pin_failures_ = 0;
+        trace_out_.reset(); // cierra la grabación anterior antes de reabrir
+        if (!cfg_.record_trace.empty()) {
+            trace_out_ = std::make_unique<TraceWriter>(cfg_.record_trace);
         }
     }
 
-    void consumer(int consumerId) {
-        (void)consumerId; // no usado, pero lo dejamos por claridad
+    // Exporta latencias e imprime el resumen final
+    void finish_run() {
+        if (trace_out_) trace_out_->close();
+        if (!cfg_.latency_csv.empty()) {
+            write_latency_csv(cfg_.latency_csv);
+        }
 
-        while (true) {
-            Task task;
+        if (!cfg_.verbose) return;
 
-            {
-                std::unique_lock<std::mutex> lk(mtx_);
-                cv_not_empty_.wait(lk, [&] {
-                    return stop_consumers.load() || !queue_.empty();
-                    });
+        // Resumen final
+        int pendingTotal = (int)pending_tasks();
 
-                if (stop_consumers) {
-                    return;  // en cuanto nos digan que paremos, salimos aunque haya tareas en cola
-                }
+        if (cfg_.shm_role == ShmRole::Producer) {
+            // Lo procesa y lo mide el proceso consumidor
+            std::cout << "\nProceso productor: " << next_id.load() << " tareas enviadas al segmento '"
+                << cfg_.shm_name << "' (" << pendingTotal << " en cola al terminar)\n\n";
+            return;
+        }
 
-                if (queue_.empty()) {
-                    continue;
-                }
+        std::cout << "\n=============================\n";
+        std::cout << "Resumen final ("
+            << (IS_AGING ? "SIN starvation - con aging" : std::string("politica ") + Policy::NAME) << ")\n";
+        std::cout << "Tareas A procesadas: " << processedA.load() << "\n";
+        std::cout << "Tareas M procesadas: " << processedM.load() << "\n";
+        std::cout << "Tareas B procesadas: " << processedB.load() << "\n";
+        std::cout << "Tareas en cola al final: " << pendingTotal << "\n";
+        std::cout << "¿Cola vacia al terminar consumidores? "
+            << (pendingTotal == 0 ? "SI" : "NO") << "\n";
+        if (ws_queue_) {
+            std::cout << "Robos entre consumidores: " << ws_queue_->steals() << "\n";
+        }
+        if (shm_queue_) {
+            std::cout << "Cola compartida: segmento '" << cfg_.shm_name << "' (";
+            if (cfg_.shm_role == ShmRole::Consumer) {
+                std::cout << "proceso consumidor, " << shm_queue_->producer_processes() << " proceso(s) productor(es))\n";
+            }
+            else std::cout << "productores y consumidores en este proceso)\n";
+        }
+        if (cfg_.placement != Placement::None || cfg_.node_shards) {
+            std::cout << "Afinidad: " << affinity_.topology().describe() << "; tareas consumidas en otro nodo: "
+                << cross_node_tasks_.load() << " (" << std::fixed << std::setprecision(1)
+                << 100.0 * cross_node_fraction() << "%)";
+            if (cfg_.node_shards) std::cout << ", robos entre nodos: " << remote_steals();
+            if (pin_failures_ > 0) std::cout << ", hilos sin fijar: " << pin_failures_.load();
+            std::cout << "\n";
+        }
+        if (aging_ctl_) {
+            std::cout << "Aging adaptativo: intervalo final " << std::fixed << std::setprecision(1)
+                << aging_ctl_->interval_ms() << " ms (rango " << aging_ctl_->min_interval_seen()
+                << " - " << aging_ctl_->max_interval_seen() << " ms, "
+                << aging_ctl_->adjustments() << " ajustes)\n";
+        }
+        if (cfg_.overflow != OverflowPolicy::Block) {
+            std::cout << "Rechazadas (A/M/B): " << shed_counts(rejected_) << "\n";
+            std::cout << "Descartadas de la cola (A/M/B): " << shed_counts(shed_) << "\n";
+        }
+        if (cfg_.has_deadlines()) {
+            std::cout << "Plazos (A/M/B): " << cfg_.ttl_ms[0] << "/" << cfg_.ttl_ms[1] << "/" << cfg_.ttl_ms[2]
+                << " ms; vencidas en cola: " << shed_counts(expired_)
+                << ", procesadas fuera de plazo: " << shed_counts(late_) << "\n";
+        }
+        if (cfg_.cancel_pct > 0) {
+            std::cout << "Canceladas (A/M/B): " << shed_counts(cancelled_) << "\n";
+        }
+        if (kernel_) {
+            std::cout << "Procesamiento: trabajo de CPU '" << workload_name(cfg_.workload) << "' ("
+                << std::fixed << std::setprecision(1) << kernel_->unit_us()
+                << " us por unidad, calibrado con un hilo; el servicio medido muestra la contencion)\n";
+        }
+        if (cfg_.elastic) {
+            std::cout << "Consumidores activos: promedio " << std::fixed << std::setprecision(2)
+                << average_consumers() << " (min " << min_active_ << ", max " << max_active_
+                << ", " << resizes_ << " cambios)\n";
+        }
+        if (trace_out_) {
+            std::cout << "Traza grabada: " << trace_out_->count() << " llegadas en " << cfg_.record_trace << "\n";
+        }
+        if (trace_) {
+            std::cout << "Traza reproducida: " << cfg_.replay_trace << " (" << trace_->size() << " llegadas, "
+                << std::fixed << std::setprecision(3) << trace_->duration_us() / 1e6 << " s, ";
+            if (cfg_.replay_speed > 0) std::cout << "velocidad " << std::setprecision(1) << cfg_.replay_speed << "x)\n";
+            else std::cout << "sin pausas)\n";
+        }
+        if (cfg_.coroutines) {
+            long long frames = coroutine_frames();
+            std::cout << "Corrutinas: " << cfg_.num_producers << " productores y " << cfg_.num_consumers
+                << " consumidores en " << coroutine_workers() << " hilo(s); marcos: "
+                << coroutine_frame_bytes() / 1024 << " KB (" << (frames > 0 ? coroutine_frame_bytes() / frames : 0)
+                << " bytes c/u)";
+            if (resident_kb_ >= 0) std::cout << ", memoria residente " << resident_kb_ / 1024 << " MB";
+            std::cout << "\n";
+        }
+        if (cfg_.virtual_clock) {
+            std::cout << "Reloj virtual: " << std::fixed << std::setprecision(3)
+                << virtual_end_us_ / 1e6 << " s simulados en "
+                << virtual_wall_ms_ << " ms reales\n";
+        }
+        std::cout << "\nLatencias (ms)\t  p50\t  p90\t  p99\tp99.9\t  max\n";
+        for (size_t c = 0; c < NUM_CLASSES; ++c) {
+            std::cout << "Espera " << class_type(c) << "\t\t" << percentile_row(wait_hist_[c], "\t") << "\n";
+        }
+        for (size_t c = 0; c < NUM_CLASSES; ++c) {
+            std::cout << "Servicio " << class_type(c) << "\t" << percentile_row(service_hist_[c], "\t") << "\n";
+        }
+        std::cout << "=============================\n\n";
+    }
 
-                size_t idx = select_task_index_unlocked();
-                task = queue_[idx];
-                queue_.erase(queue_.begin() + idx);
+    // ----- Funciones auxiliares -----
 
-                cv_not_full_.notify_one();
-            }
+    static constexpr bool IS_AGING = std::is_same_v<Policy, AgingQueue>;
 
-            // Contabilizar
-            if (task.type == 'A')      ++processedA;
-            else if (task.type == 'M') ++processedM;
-            else                       ++processedB;
+    // Por defecto A = 50 ms, M = 100 ms, B = 150 ms
+    int processing_time_ms(char type) const {
+        return cfg_.processing_ms[class_index(type)];
+    }
 
-            // Simular tiempo de procesamiento
-            std::this_thread::sleep_for(std::chrono::milliseconds(processing_time_ms(task.type)));
-        }
+    // Genera tipo de tarea según la distribución (por defecto 10% A, 30% M, 60% B)
+    template <class Gen>
+    char random_task_type(Gen& gen, std::discrete_distribution<int>& dist) {
+        int idx = dist(gen); // 0 -> A, 1 -> M, 2 -> B
+        if (idx == 0) return 'A';
+        if (idx == 1) return 'M';
+        return 'B';
     }
 
-    // Hilo de monitor: imprime tabla cada 2 segundos
-    void monitor() {
-        std::cout << "\n=====================================\n";
-        std::cout << "VERSION SIN STARVATION (con aging)\n";
-        std::cout << "Tiempo(s)\tA_proc\tM_proc\tB_proc\tB_espera\tEstado_cola\n";
-        std::cout << "-------------------------------------\n";
+    size_t pending_tasks() {
+        if (lf_queue_) return lf_queue_->size();
+        if (ws_queue_) return ws_queue_->size();
+        if (shm_queue_) return shm_queue_->size();
+        std::lock_guard<std::mutex> lk(mtx_);
+        return queue_.size();
+    }
 
-        for (int elapsed = 2; elapsed <= RUN_SECONDS; elapsed += 2) {
-            std::this_thread::sleep_for(std::chrono::seconds(2));
+    // Consumidor: si la cola quedó vacía con la producción detenida, run()
+    // puede pasar a detener a los consumidores
+    void notify_if_drained(bool empty) {
+        if (empty && stop_production.load()) {
+            { std::lock_guard<std::mutex> lk(signal_mtx_); }
+            drain_cv_.notify_all();
+        }
+    }
 
-            int a = processedA.load();
-            int m = processedM.load();
-            int b = processedB.load();
-            int pendingB = 0;
-            std::string state;
+    void wake_producers() {
+        if (lf_queue_) lf_queue_->wake_all();
+        if (ws_queue_) ws_queue_->wake_all();
+        if (shm_queue_) shm_queue_->wake_all();
+        cv_not_full_.notify_all();
+    }
 
-            {
-                std::lock_guard<std::mutex> lk(mtx_);
-                pendingB = std::count_if(queue_.begin(), queue_.end(),
-                    [](const Task& t) { return t.type == 'B'; });
+    void wake_consumers() {
+        if (lf_queue_) lf_queue_->wake_all();
+        if (ws_queue_) ws_queue_->wake_all();
+        if (shm_queue_) shm_queue_->wake_all();
+        cv_not_empty_.notify_all();
+        { std::lock_guard<std::mutex> lk(pool_mtx_); }
+        pool_cv_.notify_all();
+    }
 
-                std::ostringstream oss;
-                for (const auto& t : queue_) {
-                    oss << t.type << ' ';
-                }
-                state = oss.str();
-            }
+    // ---- Grupo elástico de consumidores ----
 
-            std::cout << std::setw(8) << elapsed << "\t"
-                << std::setw(6) << a << "\t"
-                << std::setw(6) << m << "\t"
-                << std::setw(6) << b << "\t"
-                << std::setw(8) << pendingB << "\t"
-                << state << "\n";
-        }
+    // Hilos consumidores que se lanzan (todos los posibles si es elástico)
+    int consumer_threads() const {
+        if (cfg_.shm_role == ShmRole::Producer) return 0;
+        return cfg_.elastic ? cfg_.pool.max_size : cfg_.num_consumers;
+    }
 
-        std::cout << "=====================================\n\n";
+    int initial_consumers() const {
+        if (!cfg_.elastic) return cfg_.num_consumers;
+        return std::clamp(cfg_.num_consumers, cfg_.pool.min_size, cfg_.pool.max_size);
     }
-};
 
-int main() {
-    Simulation sim;
-    sim.run();
+    // Estaciona al consumidor mientras su id quede fuera del tamaño activo.
+    // false si hay que detenerlo.
+    bool wait_until_active(int consumerId) {
+        if (consumerId < active_consumers_.load()) return true;
+        std::unique_lock<std::mutex> lk(pool_mtx_);
+        pool_cv_.wait(lk, [&] {
+            return stop_consumers.load() || consumerId < active_consumers_.load();
+            });
+        return !stop_consumers.load();
+    }
+
+    // Espera de una tarea que empieza a procesarse (para el escalador)
+    void note_wait_for_scaler(long long wait_us) {
+        if (!cfg_.elastic) return;
+        window_wait_us_.fetch_add(wait_us, std::memory_order_relaxed);
+        window_tasks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Un período del escalador: decide el tamaño con la profundidad actual
+    // y la espera promedio del período. Devuelve el tamaño nuevo.
+    int scale_step(size_t depth, double period_ms) {
+        long long n = window_tasks_.exchange(0);
+        long long w = window_wait_us_.exchange(0);
+        double avg_ms = n > 0 ? w / 1000.0 / n : -1.0;
+
+        int active = active_consumers_.load();
+        active_ms_sum_ += active * period_ms;
+        pool_ms_sum_ += period_ms;
+
+        int next = scaler_.decide(active, depth, MAX_QUEUE, avg_ms);
+        if (next != active) {
+            {
+                std::lock_guard<std::mutex> lk(pool_mtx_);
+                active_consumers_ = next;
+            }
+            pool_cv_.notify_all();
+            ++resizes_;
+            min_active_ = std::min(min_active_, next);
+            max_active_ = std::max(max_active_, next);
+        }
+        return next;
+    }
+
+    void scaler() {
+        start_latch_->arrive_and_wait();
+
+        for (long long tick = 1;; ++tick) {
+            auto deadline = run_start_ + milliseconds(tick * cfg_.scale_interval_ms);
+            {
+                std::unique_lock<std::mutex> lk(signal_mtx_);
+                if (helpers_cv_.wait_until(lk, deadline, [&] { return stop_helpers_; })) return;
+            }
+            scale_step(pending_tasks(), cfg_.scale_interval_ms);
+        }
+    }
+
+    Task make_task(char type) {
+        Task t;
+        t.type = type;
+        t.id = next_id++;
+        if (shm_queue_) t.id = shm_queue_->next_id(); // único entre los procesos
+        t.enqueue_time = steady_clock::now();
+        set_deadline(t);
+        set_weight(t);
+        t.node = affinity_.current_node();
+        return t;
+    }
+
+    // Microsegundos desde run_start_: instante en que el productor decide
+    // producir, antes de esperar lugar en la cola
+    long long arrival_us() const {
+        return duration_cast<microseconds>(steady_clock::now() - run_start_).count();
+    }
+
+    // Graba en la traza una tarea que ya entró a la cola con el instante de
+    // su llegada (no el de la inserción: la espera por falta de lugar es de
+    // esta ejecución y no de la carga). Una tarea que esperó lugar queda
+    // grabada después de otras que llegaron más tarde; al reproducir entra
+    // en el orden del archivo, nunca antes de su instante.
+    void record_arrival(const Task& t, long long arrival) {
+        if (trace_out_) trace_out_->append(arrival, t.id, t.type);
+    }
+
+    // Llamar con mtx_ tomado después de insertar/extraer en queue_
+    void on_enqueued_unlocked(char type) {
+        ++counters_.pending[class_index(type)];
+        ++counters_.enqueued;
+    }
+
+    void on_dequeued_unlocked(char type) {
+        --counters_.pending[class_index(type)];
+        ++counters_.dequeued;
+    }
+
+    // ---- Plazos y cancelaciones ----
+
+    // Plazo según la clase (cfg_.ttl_ms), contado desde enqueue_time
+    void set_deadline(Task& t) const {
+        int ttl = cfg_.ttl_ms[class_index(t.type)];
+        if (ttl > 0) t.deadline = t.enqueue_time + milliseconds(ttl);
+    }
+
+    // Peso del aging de la tarea: fijo por id (mismo valor en cada
+    // ejecución y al reproducir una traza), repartido en [1 - s, 1 + s]
+    void set_weight(Task& t) const {
+        if (cfg_.weight_spread <= 0) return;
+        std::uint32_t h = (std::uint32_t)t.id * 2654435761u; // hash de Knuth
+        double u = (double)(h >> 8) / (double)(1u << 24);   // [0, 1)
+        t.weight = (float)(1.0 + cfg_.weight_spread * (2.0 * u - 1.0));
+    }
+
+    // Con mtx_ tomado: inserta en queue_ y, si hay plazos o cancelaciones,
+    // anota la tarea en el índice y su vencimiento en la rueda
+    void push_unlocked(const Task& t) {
+        queue_.push(t);
+        on_enqueued_unlocked(t.type);
+        if (!cfg_.tracks_tasks()) return;
+        live_ids_.emplace(t.id, class_index(t.type));
+        if (cfg_.evict_expired && t.deadline != steady_clock::time_point::max()) {
+            expiry_wheel_.add(duration_cast<microseconds>(t.deadline - run_start_).count(), t.id);
+        }
+    }
+
+    // Con mtx_ tomado: extrae la próxima tarea según la política. Una
+    // cabeza con el plazo vencido (la rueda todavía no la sacó) se descarta
+    // y se sigue con la siguiente. false si la cola quedó vacía.
+    bool pop_live_unlocked(steady_clock::time_point now, Task& out) {
+        while (!queue_.empty()) {
+            Task t = queue_.pop_next(now);
+            if (cfg_.tracks_tasks()) {
+                live_ids_.erase(t.id);
+                if (cfg_.evict_expired && t.deadline <= now) {
+                    --counters_.pending[class_index(t.type)];
+                    ++expired_[class_index(t.type)];
+                    continue;
+                }
+            }
+            on_dequeued_unlocked(t.type);
+            adapt_aging_unlocked(t, now);
+            out = t;
+            return true;
+        }
+        return false;
+    }
+
+    // Con mtx_ tomado: saca la tarea 'id' si sigue en cola y la cuenta en
+    // 'counts' (vencidas o canceladas)
+    bool remove_unlocked(int id, std::atomic<long long> (&counts)[NUM_CLASSES]) {
+        auto it = live_ids_.find(id);
+        if (it == live_ids_.end()) return false;
+        size_t cls = it->second;
+        live_ids_.erase(it);
+        queue_.erase(cls, id);
+        --counters_.pending[cls];
+        ++counts[cls];
+        return true;
+    }
+
+    // Con mtx_ tomado: saca las tareas cuyo plazo venció hasta 'now'. Solo
+    // se miran las ranuras de la rueda que pasaron, nunca toda la cola.
+    size_t expire_unlocked(steady_clock::time_point now) {
+        if (!cfg_.evicts_expired()) return 0;
+        size_t n = 0;
+        expiry_wheel_.advance(duration_cast<microseconds>(now - run_start_).count(), [&](int id) {
+            if (remove_unlocked(id, expired_)) ++n;
+            });
+        return n;
+    }
+
+    // Hilo que vence plazos cada expiry_tick_ms aunque ningún consumidor
+    // esté extrayendo: el lugar vuelve enseguida a los productores
+    void expirer() {
+        start_latch_->arrive_and_wait();
+
+        for (long long tick = 1;; ++tick) {
+            auto deadline = run_start_ + milliseconds(tick * cfg_.expiry_tick_ms);
+            {
+                std::unique_lock<std::mutex> lk(signal_mtx_);
+                if (helpers_cv_.wait_until(lk, deadline, [&] { return stop_helpers_; })) return;
+            }
+
+            size_t n;
+            bool empty;
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                n = expire_unlocked(steady_clock::now());
+                if (n > 0) snapshot_.store(counters_);
+                empty = queue_.empty();
+            }
+            if (n == 0) continue;
+            notify_batch(cv_not_full_, n);
+            notify_if_drained(empty);
+        }
+    }
+
+    // Con probabilidad cancel_pct %, el cliente cancela una tarea reciente
+    // (una al azar entre las últimas MAX_QUEUE producidas; si ya salió de
+    // la cola no pasa nada)
+    template <class Gen>
+    void maybe_cancel(Gen& gen) {
+        if (cfg_.cancel_pct <= 0) return;
+        if (std::uniform_int_distribution<int>(0, 99)(gen) >= cfg_.cancel_pct) return;
+        int id = next_id.load() - 1 - std::uniform_int_distribution<int>(0, (int)MAX_QUEUE - 1)(gen);
+        if (id >= 0) cancel(id);
+    }
+
+    // Con mtx_ tomado, por cada tarea extraída en 'now': alimenta al
+    // controlador de aging y aplica a la cola el intervalo que decida
+    void adapt_aging_unlocked(const Task& t, steady_clock::time_point now) {
+        if constexpr (IS_AGING) {
+            if (!aging_ctl_) return;
+            aging_ctl_->record(t.type, duration_cast<microseconds>(now - t.enqueue_time).count());
+            if (aging_ctl_->update(now)) {
+                queue_.set_aging_interval(aging_ctl_->interval_ms());
+                aging_now_ms_.store(aging_ctl_->interval_ms());
+            }
+        }
+    }
+
+    // Lectura para el monitor: nunca toma mtx_
+    QueueSnapshot read_snapshot() const {
+        if (lf_queue_ || ws_queue_ || shm_queue_) {
+            // Estos backends ya llevan contadores atómicos propios
+            QueueSnapshot snap{};
+            for (size_t c = 0; c < NUM_CLASSES; ++c) {
+                snap.pending[c] = (long long)(lf_queue_ ? lf_queue_->count(class_type(c))
+                    : ws_queue_ ? ws_queue_->count(class_type(c)) : shm_queue_->count(class_type(c)));
+            }
+            snap.enqueued = next_id.load();
+            snap.dequeued = processed_total();
+            return snap;
+        }
+        return snapshot_.load();
+    }
+
+    // Una tanda de n tareas se anuncia con una sola notificación
+    static void notify_batch(std::condition_variable& cv, size_t n) {
+        if (n == 1) cv.notify_one();
+        else if (n > 1) cv.notify_all();
+    }
+
+    // Inserción en la cola con control de capacidad
+    void enqueue_task(char type, long long arrival = -1) {
+        if (arrival < 0) arrival = arrival_us();
+        if (lf_queue_ || ws_queue_ || shm_queue_) {
+            Task t = make_task(type);
+            bool ok = lf_queue_ ? lf_queue_->push(t, stop_production)
+                : ws_queue_ ? ws_queue_->push(t, stop_production) : shm_queue_->push(t, stop_production);
+            if (ok) {
+                note_depth(pending_tasks());
+                record_arrival(t, arrival);
+            }
+            return;
+        }
+
+        std::unique_lock<std::mutex> lk(mtx_);
+        cv_not_full_.wait(lk, [&] {
+            ++lock_acquisitions_; // el predicado corre cada vez que se (re)toma el lock
+            return stop_production.load() || queue_.size() < MAX_QUEUE;
+            });
+
+        if (stop_production) {
+            return; // ya no agregamos más tareas
+        }
+
+        Task t = make_task(type);
+        push_unlocked(t);
+        record_arrival(t, arrival);
+        note_depth(queue_.size());
+        snapshot_.store(counters_);
+
+        cv_not_empty_.notify_one();
+    }
+
+    // "a/m/b" de un contador por clase
+    static std::string shed_counts(const std::atomic<long long> (&counts)[NUM_CLASSES]) {
+        return std::to_string(counts[0].load()) + "/" + std::to_string(counts[1].load()) +
+            "/" + std::to_string(counts[2].load());
+    }
+
+    // Ocupación a partir de la cual ya no se admite la clase
+    size_t admit_limit(char type) const {
+        if (cfg_.overflow != OverflowPolicy::RejectByClass) return MAX_QUEUE;
+        size_t limit = MAX_QUEUE * (size_t)cfg_.admit_pct[class_index(type)] / 100;
+        return std::max<size_t>(limit, 1);
+    }
+
+    // Con mtx_ tomado y sin lugar para 'type': aplica la política de
+    // descarte. true si hay que insertar la tarea nueva (se desalojó otra).
+    bool shed_unlocked(char type) {
+        if (cfg_.overflow == OverflowPolicy::DropOldestLowest) {
+            // La clase más baja en cola, si no es más prioritaria que la nueva
+            for (size_t c = NUM_CLASSES; c-- > 0;) {
+                if (queue_.count(class_type(c)) == 0) continue;
+                if (base_priority(class_type(c)) > base_priority(type)) break;
+                live_ids_.erase(queue_.evict_oldest(c).id);
+                --counters_.pending[c];
+                ++shed_[c];
+                return true;
+            }
+        }
+        ++rejected_[class_index(type)];
+        return false;
+    }
+
+    // Inserción del productor según cfg_.overflow
+    void produce(char type) {
+        if (cfg_.overflow == OverflowPolicy::Block) enqueue_task(type);
+        else if (cfg_.enqueue_timeout_ms == 0) try_enqueue(type);
+        else enqueue_for(type, milliseconds(cfg_.enqueue_timeout_ms));
+    }
+
+    // Inserción por tandas: mete todas las tareas que quepan con una sola
+    // toma del lock y una sola notificación; si no caben todas, espera lugar
+    // para el resto.
+    void enqueue_batch(std::span<const char> types) {
+        long long arrival = arrival_us();
+        if (lf_queue_ || ws_queue_ || shm_queue_) {
+            for (char type : types) enqueue_task(type, arrival);
+            return;
+        }
+
+        size_t done = 0;
+        while (done < types.size()) {
+            std::unique_lock<std::mutex> lk(mtx_);
+            cv_not_full_.wait(lk, [&] {
+                ++lock_acquisitions_;
+                return stop_production.load() || queue_.size() < MAX_QUEUE;
+                });
+
+            if (stop_production) {
+                return;
+            }
+
+            size_t n = std::min(types.size() - done, MAX_QUEUE - queue_.size());
+            for (size_t i = 0; i < n; ++i) {
+                Task t = make_task(types[done + i]);
+                push_unlocked(t);
+                record_arrival(t, arrival);
+            }
+            snapshot_.store(counters_);
+            note_depth(queue_.size());
+            done += n;
+
+            notify_batch(cv_not_empty_, n);
+        }
+    }
+
+    // ---- Lógica de hilos ----
+
+    // Productor: productor 0 genera la secuencia fija de 30 tareas,
+    // luego todos generan con distribución probabilística.
+    void producer(int producerId) {
+        if (!affinity_.apply(producerId)) ++pin_failures_;
+        start_latch_->arrive_and_wait();
+
+        // Random engine por hilo
+        std::random_device rd;
+        std::mt19937 gen(rd() + producerId * 1000);
+        std::discrete_distribution<int> dist(cfg_.weights.begin(), cfg_.weights.end()); // A, M, B
+
+        // El productor 0 genera la secuencia fija
+        if (producerId == 0) {
+            for (char type : initial_sequence) {
+                if (stop_production) break;
+                produce(type);
+                pace_production();
+            }
+            initial_done = true;
+            initial_done.notify_all();
+        }
+        else {
+            // Los demás esperan hasta que la secuencia fija haya terminado
+            // (el productor 0 la marca aunque se detenga antes)
+            initial_done.wait(false);
+        }
+
+        // Después de la secuencia fija, todos producen con la distribución dada
+        if (cfg_.producer_batch > 1 && cfg_.overflow == OverflowPolicy::Block) {
+            std::vector<char> batch(cfg_.producer_batch);
+            while (!stop_production) {
+                for (char& t : batch) t = random_task_type(gen, dist);
+                enqueue_batch(batch);
+                maybe_cancel(gen);
+                pace_production((int)batch.size());
+            }
+            return;
+        }
+
+        while (!stop_production) {
+            char t = random_task_type(gen, dist);
+            produce(t);
+            maybe_cancel(gen);
+            pace_production();
+        }
+    }
+
+    // Pausa entre producciones (n tareas producidas juntas = n pausas)
+    void pace_production(int n = 1) {
+        long long since_start = duration_cast<microseconds>(steady_clock::now() - run_start_).count();
+        long long us = production_interval_us(since_start);
+        if (us > 0) {
+            std::this_thread::sleep_for(microseconds(us * n));
+        }
+    }
+
+    // Pausa entre producciones a 't_us' del inicio. Con ráfagas, durante
+    // los primeros burst_ms de cada período se produce a
+    // produce_interval_ms y el resto del período a quiet_interval_ms.
+    long long production_interval_us(long long t_us) const {
+        if (cfg_.burst_period_ms > 0 &&
+            t_us % (cfg_.burst_period_ms * 1000LL) >= cfg_.burst_ms * 1000LL) {
+            return cfg_.quiet_interval_ms * 1000LL;
+        }
+        return cfg_.produce_interval_ms * 1000LL;
+    }
+
+    // ---- Reproducción de trazas ----
+
+    // Hilos productores (reproduciendo una traza, uno solo; ninguno en un
+    // proceso solo consumidor)
+    int producer_threads() const {
+        if (cfg_.shm_role == ShmRole::Consumer) return 0;
+        return trace_ ? 1 : cfg_.num_producers;
+    }
+
+    // Rol consumidor: la producción termina cuando se conectaron los
+    // cfg_.shm_producers procesos productores y se desconectaron todos (los
+    // que mueren sin despedirse se descartan por PID). Pasados run_ms más
+    // SHM_GRACE_MS (margen para que arranquen) se deja de esperar en
+    // cualquier caso: productores que faltan o que siguen conectados.
+    // false si se dejó de esperar con productores conectados.
+    static constexpr int SHM_GRACE_MS = 10000;
+
+    bool wait_remote_producers() {
+        auto giveUp = run_start_ + milliseconds(cfg_.run_ms + SHM_GRACE_MS);
+        bool done = true;
+        while (!shm_queue_->wait_producers_done(cfg_.shm_producers, milliseconds(100))) {
+            if (steady_clock::now() >= giveUp) {
+                std::cerr << "Se deja de esperar a los productores de '" << cfg_.shm_name << "': se conectaron "
+                    << shm_queue_->producer_processes() << " de " << cfg_.shm_producers << ", siguen conectados "
+                    << shm_queue_->connected_producers() << "\n";
+                done = shm_queue_->connected_producers() == 0;
+                break;
+            }
+        }
+        if (int dead = shm_queue_->dead_producers(); dead > 0) {
+            std::cerr << dead << " proceso(s) productor(es) terminaron sin desconectarse\n";
+        }
+        return done;
+    }
+
+    // Instante (us desde el inicio) en que se reproduce la llegada i
+    long long replay_offset_us(size_t i) const {
+        if (cfg_.replay_speed <= 0) return 0;
+        return (long long)((double)(*trace_)[i].offset_us / cfg_.replay_speed);
+    }
+
+    // Duración de la producción: run_ms o lo que dura la traza
+    long long production_ms() const {
+        if (!trace_ || cfg_.replay_speed <= 0) return cfg_.run_ms;
+        return (long long)(trace_->duration_us() / cfg_.replay_speed) / 1000;
+    }
+
+    // Un solo productor recorre la traza mapeada e inserta cada llegada en
+    // su instante (produce() respeta cfg_.overflow: con block, si la cola
+    // está llena la reproducción se atrasa igual que un productor real)
+    void replay_producer() {
+        start_latch_->arrive_and_wait();
+        initial_done = true;
+        initial_done.notify_all();
+
+        for (size_t i = 0; i < trace_->size() && !stop_production; ++i) {
+            if (cfg_.replay_speed > 0) {
+                std::this_thread::sleep_until(run_start_ + microseconds(replay_offset_us(i)));
+            }
+            produce((*trace_)[i].type);
+        }
+    }
+
+    // Extracción con aging; false cuando hay que detener al consumidor
+    bool dequeue_task(int consumerId, Task& task) {
+        if (lf_queue_) {
+            if (!lf_queue_->pop(task, stop_consumers)) return false;
+            notify_if_drained(lf_queue_->empty());
+            return true;
+        }
+        if (ws_queue_) {
+            if (!ws_queue_->pop((size_t)consumerId, task, stop_consumers)) return false;
+            notify_if_drained(ws_queue_->empty());
+            return true;
+        }
+        if (shm_queue_) {
+            // Con productores remotos todavía activos la cola no se vacía:
+            // al detener se sale aunque queden tareas
+            if (stop_consumers || !shm_queue_->pop(task, stop_consumers)) return false;
+            notify_if_drained(shm_queue_->empty());
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lk(mtx_);
+        size_t before;
+        for (;;) {
+            cv_not_empty_.wait(lk, [&] {
+                ++lock_acquisitions_;
+                return stop_consumers.load() || !queue_.empty();
+                });
+
+            if (stop_consumers) {
+                return false;  // en cuanto nos digan que paremos, salimos aunque haya tareas en cola
+            }
+
+            // Selección en O(1) según la política: solo se miran las cabezas
+            // de cada clase (ver scheduling_policies.h)
+            before = queue_.size();
+            if (pop_live_unlocked(steady_clock::now(), task)) break;
+            release_expired(lk);
+        }
+        snapshot_.store(counters_);
+        bool empty = queue_.empty();
+        size_t freed = before - queue_.size(); // la extraída y las vencidas
+        lk.unlock();
+
+        notify_batch(cv_not_full_, freed);
+        notify_if_drained(empty);
+        return true;
+    }
+
+    // La cola solo tenía tareas vencidas y quedó vacía: avisar a los
+    // productores y a run() antes de volver a esperar
+    void release_expired(std::unique_lock<std::mutex>& lk) {
+        snapshot_.store(counters_);
+        lk.unlock();
+        cv_not_full_.notify_all();
+        notify_if_drained(true);
+        lk.lock();
+    }
+
+    // Extracción por tandas: hasta max_n tareas con una sola toma del lock.
+    // Todas se eligen con el mismo 'now', así que la tanda es exactamente la
+    // secuencia que darían max_n extracciones seguidas con aging.
+    // Devuelve 0 cuando hay que detener al consumidor.
+    size_t dequeue_batch(int consumerId, size_t max_n, std::vector<Task>& out) {
+        out.clear();
+        if (lf_queue_ || ws_queue_ || shm_queue_) {
+            Task task;
+            if (dequeue_task(consumerId, task)) out.push_back(task);
+            return out.size();
+        }
+
+        std::unique_lock<std::mutex> lk(mtx_);
+        size_t before;
+        for (;;) {
+            cv_not_empty_.wait(lk, [&] {
+                ++lock_acquisitions_;
+                return stop_consumers.load() || !queue_.empty();
+                });
+
+            if (stop_consumers) {
+                return 0;
+            }
+
+            auto now = steady_clock::now();
+            before = queue_.size();
+            Task task;
+            while (out.size() < max_n && pop_live_unlocked(now, task)) out.push_back(task);
+            if (!out.empty()) break;
+            release_expired(lk);
+        }
+        snapshot_.store(counters_);
+        bool empty = queue_.empty();
+        size_t freed = before - queue_.size();
+        lk.unlock();
+
+        notify_batch(cv_not_full_, freed);
+        notify_if_drained(empty);
+        return out.size();
+    }
+
+    void consumer(int consumerId) {
+        if (!affinity_.apply(consumerId)) ++pin_failures_;
+        start_latch_->arrive_and_wait();
+
+        // Tráfico entre nodos: se acumula localmente y se publica al salir
+        long long tagged = 0, cross = 0;
+        std::vector<Task> batch;
+        while (next_batch(consumerId, batch)) {
+            for (const Task& task : batch) {
+                int node = affinity_.current_node();
+                if (task.node >= 0 && node >= 0) {
+                    ++tagged;
+                    if (task.node != node) ++cross;
+                }
+                process_task(task);
+            }
+        }
+        node_tasks_ += tagged;
+        cross_node_tasks_ += cross;
+    }
+
+    // Siguiente tanda del consumidor; false cuando hay que detenerlo
+    bool next_batch(int consumerId, std::vector<Task>& batch) {
+        if (cfg_.elastic && !wait_until_active(consumerId)) {
+            return false;
+        }
+
+        if (cfg_.consumer_batch > 1) {
+            return dequeue_batch(consumerId, (size_t)cfg_.consumer_batch, batch) > 0;
+        }
+
+        Task task;
+        if (!dequeue_task(consumerId, task)) {
+            return false;
+        }
+        batch.assign(1, task);
+        return true;
+    }
+
+    void process_task(const Task& task) {
+        auto start = begin_task(task);
+
+        // Simular tiempo de procesamiento: dormir o trabajar en la CPU
+        if (kernel_) {
+            kernel_sink_.fetch_add(kernel_->run(processing_time_ms(task.type), (std::uint64_t)task.id),
+                std::memory_order_relaxed);
+        }
+        else if (cfg_.simulate_processing) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(processing_time_ms(task.type)));
+        }
+
+        end_task(task, start);
+    }
+
+    // Registra la espera y contabiliza la tarea; devuelve el inicio del servicio
+    steady_clock::time_point begin_task(const Task& task) {
+        auto start = steady_clock::now();
+        long long wait_us = duration_cast<microseconds>(start - task.enqueue_time).count();
+        wait_hist_[class_index(task.type)].record(wait_us);
+        note_wait_for_scaler(wait_us);
+        if (task.deadline < start) ++late_[class_index(task.type)];
+
+        // Contabilizar
+        if (task.type == 'A')      ++processedA;
+        else if (task.type == 'M') ++processedM;
+        else                       ++processedB;
+        return start;
+    }
+
+    void end_task(const Task& task, steady_clock::time_point start) {
+        service_hist_[class_index(task.type)].record(
+            duration_cast<microseconds>(steady_clock::now() - start).count());
+    }
+
+    // ---- Modo corrutinas ----
+    //
+    // Productores y consumidores son corrutinas (coro_runtime.h) sobre
+    // cfg_.coro_workers hilos. Usan la misma cola, mtx_, contadores y
+    // política que el modo con hilos, pero en lugar de bloquear en
+    // cv_not_full_ / cv_not_empty_ se anotan en co_producers_ /
+    // co_consumers_ y se suspenden; quien libera lugar o inserta una tarea
+    // completa la operación del que espera (co_pump_unlocked) y lo
+    // reanuda. Los sleep_for de la producción y del procesamiento son
+    // temporizadores del planificador.
+
+    // Operación pendiente de una corrutina; vive en su marco mientras espera
+    struct CoWaiter {
+        std::coroutine_handle<> h;
+        char type = 0; // productor: clase de la tarea a insertar
+        long long arrival = 0; // productor: ver arrival_us()
+        Task task{};   // consumidor: tarea entregada
+        bool ok = false;
+    };
+
+    // co_await co_enqueue(type): true si la tarea entró a la cola
+    auto co_enqueue(char type) {
+        struct Awaiter {
+            BasicSimulation* s;
+            CoWaiter w;
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> h) {
+                w.h = h;
+                return s->co_enqueue_or_wait(w);
+            }
+            bool await_resume() const noexcept { return w.ok; }
+        };
+        CoWaiter w;
+        w.type = type;
+        w.arrival = arrival_us();
+        return Awaiter{ this, w };
+    }
+
+    // co_await co_dequeue(out): false cuando hay que detener al consumidor
+    auto co_dequeue(Task& out) {
+        struct Awaiter {
+            BasicSimulation* s;
+            Task* out;
+            CoWaiter w;
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> h) {
+                w.h = h;
+                return s->co_dequeue_or_wait(w);
+            }
+            bool await_resume() {
+                if (w.ok) *out = w.task;
+                return w.ok;
+            }
+        };
+        return Awaiter{ this, &out, CoWaiter{} };
+    }
+
+    // Inserta o anota al productor en co_producers_. true si se suspende.
+    // Sin overflow=block nunca espera: aplica la política de descarte.
+    bool co_enqueue_or_wait(CoWaiter& w) {
+        std::lock_guard<std::mutex> lk(mtx_);
+        ++lock_acquisitions_;
+        if (stop_production) {
+            w.ok = false;
+            return false;
+        }
+
+        bool block = cfg_.overflow == OverflowPolicy::Block;
+        if (queue_.size() >= admit_limit(w.type)) {
+            if (block) {
+                co_producers_.push_back(&w);
+                return true;
+            }
+            if (!shed_unlocked(w.type)) {
+                w.ok = false;
+                return false;
+            }
+        }
+
+        Task t = make_task(w.type);
+        queue_.push(t);
+        record_arrival(t, w.arrival);
+        on_enqueued_unlocked(w.type);
+        note_depth(queue_.size());
+        co_pump_unlocked();
+        snapshot_.store(counters_);
+        w.ok = true;
+        return false;
+    }
+
+    // Extrae o anota al consumidor en co_consumers_. true si se suspende.
+    bool co_dequeue_or_wait(CoWaiter& w) {
+        bool empty;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            ++lock_acquisitions_;
+            if (stop_consumers) {
+                w.ok = false;
+                return false;
+            }
+            if (queue_.empty()) {
+                co_consumers_.push_back(&w);
+                return true;
+            }
+
+            auto now = steady_clock::now();
+            w.task = queue_.pop_next(now);
+            on_dequeued_unlocked(w.task.type);
+            adapt_aging_unlocked(w.task, now);
+            co_pump_unlocked();
+            snapshot_.store(counters_);
+            empty = queue_.empty();
+        }
+        w.ok = true;
+        notify_if_drained(empty);
+        return false;
+    }
+
+    // Con mtx_ tomado: completa las esperas que ya pueden avanzar (hay
+    // tareas para los consumidores anotados o lugar para los productores)
+    // y las reanuda. Después de schedule() el CoWaiter ya no se toca: la
+    // corrutina puede estar corriendo en otro hilo.
+    void co_pump_unlocked() {
+        auto now = steady_clock::now();
+        for (bool moved = true; moved;) {
+            moved = false;
+            while (!co_consumers_.empty() && !queue_.empty()) {
+                CoWaiter* w = co_consumers_.front();
+                co_consumers_.pop_front();
+                w->task = queue_.pop_next(now);
+                on_dequeued_unlocked(w->task.type);
+                adapt_aging_unlocked(w->task, now);
+                w->ok = true;
+                co_sched_->schedule(w->h);
+                moved = true;
+            }
+            while (!co_producers_.empty() && queue_.size() < MAX_QUEUE) {
+                CoWaiter* w = co_producers_.front();
+                co_producers_.pop_front();
+                Task t = make_task(w->type);
+                queue_.push(t);
+                record_arrival(t, w->arrival);
+                on_enqueued_unlocked(w->type);
+                note_depth(queue_.size());
+                w->ok = true;
+                co_sched_->schedule(w->h);
+                moved = true;
+            }
+        }
+    }
+
+    // Reanuda a todos los anotados con ok = false (al detener)
+    void co_release(std::deque<CoWaiter*>& waiters) {
+        std::lock_guard<std::mutex> lk(mtx_);
+        for (CoWaiter* w : waiters) {
+            w->ok = false;
+            co_sched_->schedule(w->h);
+        }
+        waiters.clear();
+    }
+
+    auto co_pace() {
+        long long since_start = duration_cast<microseconds>(steady_clock::now() - run_start_).count();
+        return co_sched_->sleep_for(microseconds(production_interval_us(since_start)));
+    }
+
+    // Misma lógica que producer(). minstd_rand en lugar de mt19937 para
+    // que el marco no cargue 5 KB de estado por productor.
+    CoTask co_producer(int producerId, CoEvent& initialDone) {
+        std::minstd_rand gen(std::random_device{}() + producerId * 1000);
+        std::discrete_distribution<int> dist(cfg_.weights.begin(), cfg_.weights.end()); // A, M, B
+
+        if (producerId == 0) {
+            for (char type : initial_sequence) {
+                if (stop_production) break;
+                co_await co_enqueue(type);
+                co_await co_pace();
+            }
+            initial_done = true;
+            initialDone.set();
+        }
+        else {
+            co_await initialDone;
+        }
+
+        while (!stop_production) {
+            co_await co_enqueue(random_task_type(gen, dist));
+            co_await co_pace();
+        }
+    }
+
+    CoTask co_consumer() {
+        for (;;) {
+            Task task;
+            if (!co_await co_dequeue(task)) co_return;
+
+            auto start = begin_task(task);
+            if (kernel_) {
+                // Trabajo de CPU: ocupa el hilo del planificador, como debe
+                kernel_sink_.fetch_add(kernel_->run(processing_time_ms(task.type), (std::uint64_t)task.id),
+                    std::memory_order_relaxed);
+            }
+            else if (cfg_.simulate_processing) {
+                co_await co_sched_->sleep_for(milliseconds(processing_time_ms(task.type)));
+            }
+            end_task(task, start);
+        }
+    }
+
+    int coroutine_workers() const {
+        if (cfg_.coro_workers > 0) return cfg_.coro_workers;
+        return (int)std::max<size_t>(1, affinity_.topology().num_cpus());
+    }
+
+    // Igual que run() pero con corrutinas: el hilo principal marca el
+    // tiempo y los cierres, el monitor sigue siendo un hilo
+    void run_coroutines() {
+        reset_state();
+        CoTask::promise_type::reset_peak();
+        auto start = steady_clock::now();
+
+        start_latch_ = std::make_unique<std::latch>(cfg_.verbose ? 2 : 1);
+        std::thread monitor_thread;
+        if (cfg_.verbose) {
+            monitor_thread = std::thread(&BasicSimulation::monitor, this);
+        }
+
+        {
+            CoScheduler sched(coroutine_workers(), [this](int i) {
+                if (!affinity_.apply(i)) ++pin_failures_;
+                });
+            co_sched_ = &sched;
+            CoEvent initialDone(sched);
+
+            run_start_ = steady_clock::now();
+            start_latch_->arrive_and_wait();
+            for (int i = 0; i < cfg_.num_consumers; ++i) sched.spawn(co_consumer());
+            for (int i = 0; i < cfg_.num_producers; ++i) sched.spawn(co_producer(i, initialDone));
+
+            std::this_thread::sleep_until(run_start_ + milliseconds(cfg_.run_ms));
+            resident_kb_ = resident_kb();
+
+            stop_production = true;
+            co_release(co_producers_);
+            {
+                std::unique_lock<std::mutex> lk(signal_mtx_);
+                drain_cv_.wait(lk, [&] { return pending_tasks() == 0; });
+            }
+
+            stop_consumers = true;
+            co_release(co_consumers_);
+            sched.join();
+            co_sched_ = nullptr;
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(signal_mtx_);
+            stop_helpers_ = true;
+        }
+        helpers_cv_.notify_all();
+        if (monitor_thread.joinable()) monitor_thread.join();
+
+        elapsed_seconds_ = duration<double>(steady_clock::now() - start).count();
+        finish_run();
+    }
+
+    void write_latency_csv(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) {
+            std::cerr << "No se pudo abrir " << path << " para escribir latencias\n";
+            return;
+        }
+        out << "clase,metrica,muestras,p50_ms,p90_ms,p99_ms,p999_ms,max_ms\n";
+        for (size_t c = 0; c < NUM_CLASSES; ++c) {
+            out << class_type(c) << ",espera," << wait_hist_[c].count() << ","
+                << percentile_row(wait_hist_[c], ",") << "\n";
+            out << class_type(c) << ",servicio," << service_hist_[c].count() << ","
+                << percentile_row(service_hist_[c], ",") << "\n";
+        }
+    }
+
+    // Hilo de monitor: imprime una fila cada monitor_interval_ms (2 s por
+    // defecto). Los contadores se leen del snapshot publicado sin tomar mtx_;
+    // el volcado completo de la cola sí toma el lock, por eso es muestreado:
+    // solo cada dump_queue_every filas.
+    void monitor() {
+        print_monitor_header();
+
+        start_latch_->arrive_and_wait();
+
+        const int interval = cfg_.monitor_interval_ms;
+
+        for (int tick = 1; (long long)tick * interval <= production_ms(); ++tick) {
+            auto deadline = run_start_ + milliseconds((long long)tick * interval);
+            bool stopped;
+            {
+                std::unique_lock<std::mutex> lk(signal_mtx_);
+                stopped = helpers_cv_.wait_until(lk, deadline, [&] { return stop_helpers_; });
+            }
+            // Al cerrar se imprimen los ticks ya vencidos, no se esperan los demás
+            if (stopped && steady_clock::now() < deadline) break;
+            print_monitor_tick(tick);
+        }
+
+        std::cout << "=====================================\n\n";
+    }
+
+    void print_monitor_header() {
+        std::cout << "\n=====================================\n";
+        std::cout << (IS_AGING ? "VERSION SIN STARVATION (con aging)" : std::string("POLITICA ") + Policy::NAME) << "\n";
+        std::cout << "Tiempo(s)\tA_proc\tM_proc\tB_proc\tB_espera\tEstado_cola\n";
+        std::cout << "-------------------------------------\n";
+    }
+
+    void print_monitor_tick(int tick) {
+        const int interval = cfg_.monitor_interval_ms;
+
+        int a = processedA.load();
+        int m = processedM.load();
+        int b = processedB.load();
+        QueueSnapshot snap = read_snapshot();
+        int pendingB = (int)snap.pending[class_index('B')];
+        std::string state;
+
+        bool dump = !lf_queue_ && !ws_queue_ && !shm_queue_ &&
+            cfg_.dump_queue_every > 0 && tick % cfg_.dump_queue_every == 0;
+        if (dump) {
+            std::ostringstream oss;
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                queue_.for_each([&](const Task& t) {
+                    oss << t.type << ' ';
+                    });
+            }
+            state = oss.str();
+        }
+        else {
+            // Los anillos y las colas por consumidor no se pueden recorrer
+            // sin detener a los hilos: solo conteos
+            state = "A=" + std::to_string(snap.pending[class_index('A')])
+                + " M=" + std::to_string(snap.pending[class_index('M')])
+                + " B=" + std::to_string(pendingB);
+            if (ws_queue_) state += " robos=" + std::to_string(ws_queue_->steals());
+        }
+
+        std::ostringstream elapsed;
+        if (interval % 1000 == 0) elapsed << tick * (interval / 1000);
+        else elapsed << std::fixed << std::setprecision(2) << tick * interval / 1000.0;
+
+        std::cout << std::setw(8) << elapsed.str() << "\t"
+            << std::setw(6) << a << "\t"
+            << std::setw(6) << m << "\t"
+            << std::setw(6) << b << "\t"
+            << std::setw(8) << pendingB << "\t"
+            << state << "\n";
+
+        // Espera en cola hasta ahora (p50/p90/p99/p99.9/max, ms)
+        std::cout << "        espera(ms)";
+        for (size_t c = 0; c < NUM_CLASSES; ++c) {
+            std::cout << "  " << class_type(c) << " " << percentile_row(wait_hist_[c], "/");
+        }
+        std::cout << "\n";
+        if (aging_ctl_) {
+            std::cout << "        aging(ms)  " << std::fixed << std::setprecision(1)
+                << aging_now_ms_.load() << "\n";
+        }
+        if (cfg_.elastic) {
+            std::cout << "        consumidores  " << active_consumers_.load() << "\n";
+        }
+        if (cfg_.overflow != OverflowPolicy::Block) {
+            std::cout << "        rechazadas " << shed_counts(rejected_) << "  descartadas " << shed_counts(shed_) << "\n";
+        }
+        if (cfg_.tracks_tasks()) {
+            std::cout << "        vencidas " << shed_counts(expired_) << "  canceladas " << shed_counts(cancelled_) << "\n";
+        }
+    }
+
+    // ---- Modo de reloj virtual ----
+
+    // Misma lógica de productores, consumidores y aging, pero sobre un reloj
+    // simulado: en vez de dormir se programan eventos y se salta al siguiente.
+    // Es determinista (semilla fija) y 10 s o 10 h de simulación tardan
+    // milisegundos. Siempre usa la cola indexada (queue_) de un solo hilo.
+    //
+    // Equivalencias con la versión con hilos:
+    //   cv_not_full_  -> cola FIFO de productores bloqueados
+    //   cv_not_empty_ -> cola FIFO de consumidores ociosos
+    //   sleep_for     -> evento programado en now + duración
+    struct VirtualEvent {
+        enum Kind { Produce, Finish, Monitor, Scale, EnqueueTimeout, Expire };
+        long long time_us;
+        long long seq;      // desempate estable entre eventos simultáneos
+        Kind kind;
+        int who;            // productor, consumidor o tick del monitor
+        Task task;          // tarea en proceso (Finish)
+
+        bool operator>(const VirtualEvent& o) const {
+            return time_us != o.time_us ? time_us > o.time_us : seq > o.seq;
+        }
+    };
+
+    static steady_clock::time_point virtual_time(long long us) {
+        return steady_clock::time_point(duration_cast<steady_clock::duration>(microseconds(us)));
+    }
+
+    void run_virtual() {
+        auto wall0 = steady_clock::now();
+        run_start_ = virtual_time(0); // los plazos de la rueda se cuentan desde acá
+        reset_state();
+
+        std::priority_queue<VirtualEvent, std::vector<VirtualEvent>, std::greater<VirtualEvent>> events;
+        long long seq = 0;
+        auto schedule = [&](long long t, VirtualEvent::Kind kind, int who, const Task& task = Task{}) {
+            events.push({ t, seq++, kind, who, task });
+        };
+
+        // Reproduciendo una traza la producción termina con la traza
+        const long long stop_us = trace_ ? std::numeric_limits<long long>::max() : (long long)cfg_.run_ms * 1000;
+        size_t replay_pos = 0;
+
+        // Próxima producción de 'p': tras la pausa normal o, reproduciendo,
+        // en el instante de la llegada siguiente (si el productor quedó
+        // bloqueado y ya pasó, enseguida)
+        auto next_produce = [&](int p, long long now) {
+            if (!trace_) {
+                schedule(now + production_interval_us(now), VirtualEvent::Produce, p);
+            }
+            else if (replay_pos < trace_->size()) {
+                schedule(std::max(now, replay_offset_us(replay_pos)), VirtualEvent::Produce, p);
+            }
+        };
+
+        std::vector<std::mt19937> gens;
+        for (int p = 0; p < cfg_.num_producers; ++p) {
+            gens.emplace_back(cfg_.seed + p * 1000);
+        }
+        std::discrete_distribution<int> dist(cfg_.weights.begin(), cfg_.weights.end()); // A, M, B
+        size_t initial_pos = 0;
+
+        std::deque<int> blocked;       // productores esperando lugar
+        std::vector<char> blocked_type(cfg_.num_producers);
+        std::vector<long long> blocked_until(cfg_.num_producers, -1); // plazo de enqueue_for
+        std::vector<long long> blocked_since(cfg_.num_producers, 0);  // llegada de la tarea bloqueada
+        std::deque<int> idle;          // consumidores esperando tareas
+        std::vector<bool> busy(consumer_threads(), false);
+        std::vector<int> waiting_initial;
+        bool stopped = false;
+
+        for (int c = 0; c < active_consumers_.load(); ++c) idle.push_back(c);
+        if (cfg_.elastic) schedule(cfg_.scale_interval_ms * 1000LL, VirtualEvent::Scale, 0);
+        const long long expiry_tick_us = cfg_.expiry_tick_ms * 1000LL;
+        if (cfg_.evicts_expired()) schedule(expiry_tick_us, VirtualEvent::Expire, 0);
+        if (trace_) next_produce(0, 0);
+        else if (cfg_.num_producers > 0) schedule(0, VirtualEvent::Produce, 0);
+        for (int p = 1; p < producer_threads(); ++p) {
+            if (initial_sequence.empty()) schedule(0, VirtualEvent::Produce, p);
+            else waiting_initial.push_back(p);
+        }
+        if (cfg_.verbose) {
+            print_monitor_header();
+            for (int tick = 1; (long long)tick * cfg_.monitor_interval_ms <= production_ms(); ++tick) {
+                schedule((long long)tick * cfg_.monitor_interval_ms * 1000, VirtualEvent::Monitor, tick);
+            }
+        }
+
+        // 'arrival': cuando el productor decidió producir (antes de quedar
+        // bloqueado); es lo que se graba en la traza
+        auto push_task = [&](char type, long long now, long long arrival) {
+            Task t;
+            t.type = type;
+            t.id = next_id++;
+            t.enqueue_time = virtual_time(now);
+            set_deadline(t);
+            set_weight(t);
+            record_arrival(t, arrival);
+            push_unlocked(t);
+            note_depth(queue_.size());
+        };
+
+        // Lugar liberado sin extraer (vencidas o canceladas): entran los
+        // productores bloqueados que quepan
+        auto admit_blocked = [&](long long now) {
+            while (!blocked.empty() && queue_.size() < admit_limit(blocked_type[blocked.front()])) {
+                int p = blocked.front();
+                blocked.pop_front();
+                blocked_until[p] = -1;
+                push_task(blocked_type[p], now, blocked_since[p]);
+                next_produce(p, now);
+            }
+        };
+
+        // Reparte tareas a consumidores ociosos; cada extracción libera un
+        // lugar que puede destrabar a un productor bloqueado.
+        auto dispatch = [&](long long now) {
+            Task t;
+            while (!idle.empty() && pop_live_unlocked(virtual_time(now), t)) {
+                int c = idle.front();
+                idle.pop_front();
+
+                long long enqueued_us = duration_cast<microseconds>(t.enqueue_time.time_since_epoch()).count();
+                wait_hist_[class_index(t.type)].record(now - enqueued_us);
+                note_wait_for_scaler(now - enqueued_us);
+                if (t.deadline < virtual_time(now)) ++late_[class_index(t.type)];
+                busy[c] = true;
+
+                if (t.type == 'A')      ++processedA;
+                else if (t.type == 'M') ++processedM;
+                else                    ++processedB;
+
+                schedule(now + processing_time_ms(t.type) * 1000LL, VirtualEvent::Finish, c, t);
+
+                if (!blocked.empty() && queue_.size() < admit_limit(blocked_type[blocked.front()])) {
+                    int p = blocked.front();
+                    blocked.pop_front();
+                    blocked_until[p] = -1;
+                    push_task(blocked_type[p], now, blocked_since[p]);
+                    next_produce(p, now);
+                }
+            }
+            snapshot_.store(counters_);
+        };
+
+        while (!events.empty()) {
+            VirtualEvent ev = events.top();
+            events.pop();
+            long long now = ev.time_us;
+
+            if (!stopped && now >= stop_us) {
+                // Parar producción: los productores bloqueados se retiran
+                stopped = true;
+                blocked.clear();
+            }
+
+            switch (ev.kind) {
+            case VirtualEvent::Produce: {
+                if (stopped) break;
+                int p = ev.who;
+                char type;
+                if (trace_) {
+                    type = (*trace_)[replay_pos++].type;
+                }
+                else if (p == 0 && initial_pos < initial_sequence.size()) {
+                    type = initial_sequence[initial_pos++];
+                    if (initial_pos == initial_sequence.size()) {
+                        for (int w : waiting_initial) schedule(now, VirtualEvent::Produce, w);
+                        waiting_initial.clear();
+                    }
+                }
+                else {
+                    int idx = dist(gens[p]);
+                    type = idx == 0 ? 'A' : (idx == 1 ? 'M' : 'B');
+                }
+
+                if (queue_.size() < admit_limit(type)) {
+                    push_task(type, now, now);
+                    next_produce(p, now);
+                }
+                else if (cfg_.overflow != OverflowPolicy::Block && cfg_.enqueue_timeout_ms <= 0) {
+                    // try_enqueue: se descarta en el momento y se sigue
+                    // produciendo. El productor no se bloquea, así que solo
+                    // avanza el reloj porque el constructor exige
+                    // interval-ms > 0 en modo virtual.
+                    if (shed_unlocked(type)) push_task(type, now, now);
+                    next_produce(p, now);
+                }
+                else {
+                    blocked_type[p] = type;
+                    blocked_since[p] = now;
+                    blocked.push_back(p);
+                    if (cfg_.overflow != OverflowPolicy::Block) {
+                        blocked_until[p] = now + cfg_.enqueue_timeout_ms * 1000LL;
+                        schedule(blocked_until[p], VirtualEvent::EnqueueTimeout, p);
+                    }
+                }
+                if (!trace_) {
+                    maybe_cancel(gens[p]);
+                    admit_blocked(now);
+                }
+                dispatch(now);
+                break;
+            }
+            case VirtualEvent::Expire:
+                // Un tick de la rueda de plazos; sigue mientras pueda vencer algo
+                if (expire_unlocked(virtual_time(now)) > 0) admit_blocked(now);
+                dispatch(now);
+                if (!stopped || !queue_.empty()) schedule(now + expiry_tick_us, VirtualEvent::Expire, 0);
+                break;
+            case VirtualEvent::EnqueueTimeout: {
+                // enqueue_for venció sin lugar: descartar y seguir produciendo
+                int p = ev.who;
+                auto it = std::find(blocked.begin(), blocked.end(), p);
+                if (blocked_until[p] != now || it == blocked.end()) break; // ya entró o se detuvo
+                blocked.erase(it);
+                blocked_until[p] = -1;
+                if (shed_unlocked(blocked_type[p])) push_task(blocked_type[p], now, blocked_since[p]);
+                next_produce(p, now);
+                dispatch(now);
+                break;
+            }
+            case VirtualEvent::Finish:
+                service_hist_[class_index(ev.task.type)].record(processing_time_ms(ev.task.type) * 1000LL);
+                busy[ev.who] = false;
+                if (ev.who < active_consumers_.load()) idle.push_back(ev.who); // si no, se estaciona
+                dispatch(now);
+                break;
+            case VirtualEvent::Scale: {
+                // Los consumidores ociosos son los activos que no están procesando
+                int active = scale_step(queue_.size(), cfg_.scale_interval_ms);
+                idle.clear();
+                for (int c = 0; c < active; ++c) {
+                    if (!busy[c]) idle.push_back(c);
+                }
+                dispatch(now);
+
+                bool working = std::find(busy.begin(), busy.end(), true) != busy.end();
+                if (!stopped || !queue_.empty() || working) {
+                    schedule(now + cfg_.scale_interval_ms * 1000LL, VirtualEvent::Scale, 0);
+                }
+                break;
+            }
+            case VirtualEvent::Monitor:
+                print_monitor_tick(ev.who);
+                break;
+            }
+            virtual_end_us_ = now;
+        }
+
+        if (cfg_.verbose) {
+            std::cout << "=====================================\n\n";
+        }
+
+        virtual_wall_ms_ = duration<double, std::milli>(steady_clock::now() - wall0).count();
+        elapsed_seconds_ = virtual_end_us_ / 1e6;
+        finish_run();
+    }
+};
+
+// La simulación original: cola con aging
+using Simulation = BasicSimulation<AgingQueue>;
+
+// Llama a f(std::type_identity<P>{}) con la política P que indica 'p'.
+// Cada rama instancia su propia BasicSimulation<P>.
+template <class F>
+void with_policy(SchedPolicy p, F&& f) {
+    switch (p) {
+    case SchedPolicy::Strict:            f(std::type_identity<StrictPriorityQueue>{}); return;
+    case SchedPolicy::Aging:             f(std::type_identity<AgingQueue>{}); return;
+    case SchedPolicy::WeightedFair:      f(std::type_identity<WeightedFairQueue>{}); return;
+    case SchedPolicy::DeficitRoundRobin: f(std::type_identity<DeficitRoundRobin>{}); return;
+    case SchedPolicy::EarliestDeadline:  f(std::type_identity<EarliestDeadlineQueue>{}); return;
+    case SchedPolicy::WeightedAging:     f(std::type_identity<WeightedAgingQueue>{}); return;
+    }
+}
+
+// ----- Benchmarks -----
+
+// Latencia de extracción según la profundidad de la cola: recorrido lineal
+// original contra la cola indexada por clase. Ambas reciben la misma
+// secuencia de tareas y se verifica que elijan exactamente las mismas.
+void benchmark_scheduler() {
+    const size_t depths[] = { 20, 100, 1000, 10000, 100000 };
+    const int OPS = 2000;
+
+    std::cout << "\n===== BENCHMARK SCHEDULER (aging) =====\n";
+    std::cout << "Profundidad\tLineal(ns/op)\tBuckets(ns/op)\tMismas_elecciones\n";
+
+    for (size_t depth : depths) {
+        std::mt19937 gen(42);
+        std::discrete_distribution<int> dist({ 10, 30, 60 }); // A, M, B
+        const char types[] = { 'A', 'M', 'B' };
+
+        // Tareas iniciales separadas 100 us; las siguientes llegan a ritmo
+        // constante mientras se extrae una por operación.
+        auto base = steady_clock::now();
+        std::vector<Task> initial(depth);
+        for (size_t i = 0; i < depth; ++i) {
+            initial[i] = { types[dist(gen)], (int)i,
+                base - microseconds(100) * (long long)(depth - i) };
+        }
+        std::vector<Task> arrivals(OPS);
+        for (int k = 0; k < OPS; ++k) {
+            arrivals[k] = { types[dist(gen)], (int)depth + k,
+                base + microseconds(50) * k };
+        }
+
+        LinearAgingQueue linear(200.0);
+        AgingQueue buckets(200.0);
+        for (const Task& t : initial) {
+            linear.push(t);
+            buckets.push(t);
+        }
+
+        std::vector<int> pickedLinear(OPS), pickedBuckets(OPS);
+
+        auto t0 = steady_clock::now();
+        for (int k = 0; k < OPS; ++k) {
+            pickedLinear[k] = linear.pop_next(arrivals[k].enqueue_time).id;
+            linear.push(arrivals[k]);
+        }
+        auto t1 = steady_clock::now();
+        for (int k = 0; k < OPS; ++k) {
+            pickedBuckets[k] = buckets.pop_next(arrivals[k].enqueue_time).id;
+            buckets.push(arrivals[k]);
+        }
+        auto t2 = steady_clock::now();
+
+        double nsLinear = (double)duration_cast<nanoseconds>(t1 - t0).count() / OPS;
+        double nsBuckets = (double)duration_cast<nanoseconds>(t2 - t1).count() / OPS;
+
+        std::cout << std::setw(11) << depth << "\t"
+            << std::setw(13) << std::fixed << std::setprecision(1) << nsLinear << "\t"
+            << std::setw(14) << nsBuckets << "\t"
+            << (pickedLinear == pickedBuckets ? "SI" : "NO") << "\n";
+    }
+
+    std::cout << "=======================================\n\n";
+}
+
+// Throughput (tareas/s) de los backends con N productores y N
+// consumidores, sin pausas de producción ni de procesamiento.
+void benchmark_backends() {
+    const int threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    const int RUN_MS = 500;
+
+    std::cout << "\n===== BENCHMARK BACKENDS (mutex vs lock-free vs work-stealing) =====\n";
+    std::cout << "Hilos(P+C)\tMutex(tareas/s)\tLockFree(tareas/s)\tWorkStealing(tareas/s)\n";
+
+    for (int n : threadCounts) {
+        double throughput[3] = { 0, 0, 0 };
+        const QueueBackend backends[3] = {
+            QueueBackend::MutexDeque, QueueBackend::LockFreeRing, QueueBackend::WorkStealing };
+
+        for (int b = 0; b < 3; ++b) {
+            SimConfig cfg;
+            cfg.backend = backends[b];
+            cfg.num_producers = n;
+            cfg.num_consumers = n;
+            cfg.run_ms = RUN_MS;
+            cfg.produce_interval_ms = 0;
+            cfg.simulate_processing = false;
+            cfg.verbose = false;
+
+            Simulation sim(cfg);
+            auto t0 = steady_clock::now();
+            sim.run();
+            double secs = duration<double>(steady_clock::now() - t0).count();
+            throughput[b] = sim.processed_total() / secs;
+        }
+
+        std::cout << std::setw(5) << n << "+" << std::setw(4) << std::left << n << std::right << "\t"
+            << std::setw(15) << std::fixed << std::setprecision(0) << throughput[0] << "\t"
+            << std::setw(18) << throughput[1] << "\t"
+            << std::setw(22) << throughput[2] << "\n";
+    }
+
+    std::cout << "====================================================================\n\n";
+}
+
+// Cambios de contexto (voluntarios + involuntarios) de todo el proceso;
+// -1 si la plataforma no los expone.
+long long context_switches() {
+#ifndef _WIN32
+    rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        return (long long)ru.ru_nvcsw + (long long)ru.ru_nivcsw;
+    }
+#endif
+    return -1;
+}
+
+// Tomas del lock y cambios de contexto por cada millón de tareas según el
+// tamaño de tanda (igual para productores y consumidores). 5 productores y
+// 3 consumidores como en la simulación, sin pausas.
+void benchmark_batch() {
+    const int batchSizes[] = { 1, 2, 4, 8, 16 };
+    const int RUN_MS = 1000;
+
+    std::cout << "\n===== BENCHMARK TANDAS (backend mutex) =====\n";
+    std::cout << "Tanda\tTareas/s\tLocks/1M_tareas\tCambios_ctx/1M_tareas\n";
+
+    for (int k : batchSizes) {
+        SimConfig cfg;
+        cfg.run_ms = RUN_MS;
+        cfg.produce_interval_ms = 0;
+        cfg.simulate_processing = false;
+        cfg.verbose = false;
+        cfg.producer_batch = k;
+        cfg.consumer_batch = k;
+
+        Simulation sim(cfg);
+        long long cs0 = context_switches();
+        auto t0 = steady_clock::now();
+        sim.run();
+        double secs = duration<double>(steady_clock::now() - t0).count();
+        long long cs1 = context_switches();
+
+        double tasks = std::max(1, sim.processed_total());
+        std::cout << std::setw(5) << k << "\t"
+            << std::setw(8) << std::fixed << std::setprecision(0) << tasks / secs << "\t"
+            << std::setw(15) << sim.lock_acquisitions() * 1e6 / tasks << "\t";
+        if (cs0 >= 0) std::cout << std::setw(21) << (cs1 - cs0) * 1e6 / tasks << "\n";
+        else          std::cout << std::setw(21) << "n/d" << "\n";
+    }
+
+    std::cout << "============================================\n\n";
+}
+
+// Las 6 políticas con la misma configuración (por defecto la simulación
+// original, con reloj virtual y semilla fija: todas ven las mismas llegadas).
+// Servicio% es la fracción del tiempo de procesamiento que recibió cada
+// clase; Jain es el índice de Jain de la espera p99 de las 3 clases
+// (1 = todas esperan lo mismo, 1/3 = una sola clase carga con la espera).
+void benchmark_policies(SimConfig base) {
+    base.verbose = false;
+
+    std::cout << "\n===== BENCHMARK POLITICAS (backend mutex";
+    if (base.virtual_clock) std::cout << ", reloj virtual";
+    std::cout << ") =====\n";
+    std::cout << "Politica\tTareas/s\tServicio%(A/M/B)\tEspera_p99_ms(A/M/B)\tEspera_max_ms(A/M/B)\tJain\n";
+
+    const SchedPolicy policies[] = { SchedPolicy::Strict, SchedPolicy::Aging,
+        SchedPolicy::WeightedFair, SchedPolicy::DeficitRoundRobin, SchedPolicy::EarliestDeadline,
+        SchedPolicy::WeightedAging };
+
+    for (SchedPolicy p : policies) {
+        with_policy(p, [&](auto tag) {
+            using P = typename decltype(tag)::type;
+            BasicSimulation<P> sim(base);
+            sim.run();
+
+            double busy[NUM_CLASSES], total = 0;
+            for (size_t c = 0; c < NUM_CLASSES; ++c) {
+                busy[c] = (double)sim.processed(class_type(c)) * base.processing_ms[c];
+                total += busy[c];
+            }
+
+            // Jain: (sum x)^2 / (n * sum x^2) con x = espera p99 de la clase
+            double sum = 0, sumSq = 0;
+            for (size_t c = 0; c < NUM_CLASSES; ++c) {
+                double x = (double)sim.wait_histogram(class_type(c)).percentile(0.99);
+                sum += x;
+                sumSq += x * x;
+            }
+            double jain = sumSq > 0 ? sum * sum / (NUM_CLASSES * sumSq) : 0;
+
+            double secs = sim.elapsed_seconds();
+            std::cout << std::left << std::setw(8) << P::NAME << std::right << "\t"
+                << std::fixed << std::setprecision(1)
+                << std::setw(8) << (secs > 0 ? sim.processed_total() / secs : 0.0) << "\t";
+            for (size_t c = 0; c < NUM_CLASSES; ++c) {
+                std::cout << (total > 0 ? 100.0 * busy[c] / total : 0.0) << (c + 1 < NUM_CLASSES ? "/" : "\t\t");
+            }
+            for (size_t c = 0; c < NUM_CLASSES; ++c) {
+                std::cout << sim.wait_histogram(class_type(c)).percentile(0.99) / 1000.0
+                    << (c + 1 < NUM_CLASSES ? "/" : "\t\t");
+            }
+            for (size_t c = 0; c < NUM_CLASSES; ++c) {
+                std::cout << sim.wait_histogram(class_type(c)).max() / 1000.0
+                    << (c + 1 < NUM_CLASSES ? "/" : "\t\t");
+            }
+            std::cout << std::setprecision(3) << jain << "\n";
+            });
+    }
+
+    std::cout << "==========================================================\n\n";
+}
+
+// Aging fijo contra adaptativo con llegadas en ráfagas (reloj virtual,
+// 60 s simulados, misma semilla). Fuera de la ráfaga la carga queda por
+// debajo de la capacidad de los 3 consumidores; durante la ráfaga la
+// supera con creces. Se reporta la espera p90 por clase contra el
+// objetivo del controlador (200/600/1200 ms por defecto).
+void benchmark_adaptive_aging() {
+    struct Pattern { const char* name; int period_ms; int burst_ms; };
+    const Pattern patterns[] = {
+        { "constante", 0, 0 },
+        { "rafaga 1s/4s", 4000, 1000 },
+        { "rafaga 200ms/2s", 2000, 200 },
+        { "rafaga 3s/10s", 10000, 3000 },
+    };
+    struct Mode { const char* name; double interval_ms; bool adaptive; };
+    const Mode modes[] = {
+        { "fijo 200", 200.0, false },
+        { "fijo 50", 50.0, false },
+        { "fijo 1000", 1000.0, false },
+        { "adaptativo", 200.0, true },
+    };
+
+    SimConfig base;
+    base.virtual_clock = true;
+    base.verbose = false;
+    base.run_ms = 60000;
+    const auto& target = base.aging_control.target_ms;
+
+    std::cout << "\n===== BENCHMARK AGING ADAPTATIVO (reloj virtual, 60 s) =====\n";
+    std::cout << "Objetivo p90 (ms): A " << target[0] << ", M " << target[1] << ", B " << target[2] << "\n";
+    std::cout << "Patron          \tAging     \tEspera_p90_ms(A/M/B)\tCumple(A/M/B)\tIntervalo_ms\n";
+
+    for (const Pattern& pat : patterns) {
+        for (const Mode& mode : modes) {
+            SimConfig cfg = base;
+            cfg.burst_period_ms = pat.period_ms;
+            cfg.burst_ms = pat.burst_ms;
+            cfg.aging_interval_ms = mode.interval_ms;
+            cfg.adaptive_aging = mode.adaptive;
+
+            Simulation sim(cfg);
+            sim.run();
+
+            std::ostringstream p90, ok;
+            p90 << std::fixed << std::setprecision(1);
+            for (size_t c = 0; c < NUM_CLASSES; ++c) {
+                double ms = sim.wait_histogram(class_type(c)).percentile(0.90) / 1000.0;
+                p90 << ms << (c + 1 < NUM_CLASSES ? "/" : "");
+                ok << (ms <= target[c] ? "si" : "no") << (c + 1 < NUM_CLASSES ? "/" : "");
+            }
+
+            std::cout << std::left << std::setw(16) << pat.name << "\t"
+                << std::setw(10) << mode.name << std::right << "\t"
+                << std::setw(20) << p90.str() << "\t"
+                << std::setw(13) << ok.str() << "\t";
+            if (mode.adaptive) {
+                std::cout << std::fixed << std::setprecision(1) << sim.aging_interval_ms()
+                    << " (" << sim.aging_interval_range().first << "-" << sim.aging_interval_range().second << ")\n";
+            }
+            else {
+                std::cout << mode.interval_ms << "\n";
+            }
+        }
+    }
+
+    std::cout << "=============================================================\n\n";
+}
+
+// Grupo fijo contra elástico con una carga que cambia 10x (reloj virtual,
+// 120 s simulados): ráfagas de 20 s cada 40 s con una producción cada
+// 80 ms por productor y el resto del tiempo una cada 800 ms. Consumidores
+// promedio es el costo (núcleos ocupados); la espera p90 es lo que se
+// gana con ellos.
+void benchmark_elastic() {
+    struct Mode { const char* name; bool elastic; int consumers; };
+    const Mode modes[] = {
+        { "fijo 2", false, 2 },
+        { "fijo 3", false, 3 },
+        { "fijo 8", false, 8 },
+        { "elastico 1-8", true, 1 },
+    };
+
+    SimConfig base;
+    base.virtual_clock = true;
+    base.verbose = false;
+    base.run_ms = 120000;
+    base.produce_interval_ms = 80;
+    base.quiet_interval_ms = 800;
+    base.burst_period_ms = 40000;
+    base.burst_ms = 20000;
+    base.pool.min_size = 1;
+    base.pool.max_size = 8;
+
+    std::cout << "\n===== BENCHMARK GRUPO ELASTICO (reloj virtual, 120 s, carga 10x) =====\n";
+    std::cout << "Consumidores \tTareas/s\tPromedio\tCambios\tEspera_p90_ms(A/M/B)\tEspera_max_ms(A/M/B)\n";
+
+    for (const Mode& mode : modes) {
+        SimConfig cfg = base;
+        cfg.elastic = mode.elastic;
+        cfg.num_consumers = mode.consumers;
+
+        Simulation sim(cfg);
+        sim.run();
+
+        std::ostringstream p90, mx;
+        p90 << std::fixed << std::setprecision(1);
+        mx << std::fixed << std::setprecision(1);
+        for (size_t c = 0; c < NUM_CLASSES; ++c) {
+            const LatencyHistogram& h = sim.wait_histogram(class_type(c));
+            p90 << h.percentile(0.90) / 1000.0 << (c + 1 < NUM_CLASSES ? "/" : "");
+            mx << h.max() / 1000.0 << (c + 1 < NUM_CLASSES ? "/" : "");
+        }
+
+        double secs = sim.elapsed_seconds();
+        std::cout << std::left << std::setw(13) << mode.name << std::right << "\t"
+            << std::fixed << std::setprecision(1) << std::setw(8)
+            << (secs > 0 ? sim.processed_total() / secs : 0.0) << "\t"
+            << std::setprecision(2) << std::setw(8) << sim.average_consumers() << "\t"
+            << std::setw(7) << sim.pool_resizes() << "\t"
+            << std::setw(20) << p90.str() << "\t" << mx.str() << "\n";
+    }
+
+    std::cout << "=====================================================================\n\n";
+}
+
+// Throughput y tráfico entre nodos con y sin fijar hilos: un productor y
+// un consumidor por CPU, sin pausas. "Otro nodo" es la fracción de tareas
+// consumidas en un nodo distinto del que las produjo; con un solo nodo
+// siempre es 0 y solo se mide el efecto de fijar a núcleos.
+void benchmark_affinity() {
+    struct Mode { const char* name; QueueBackend backend; Placement placement; bool node_shards; };
+    const Mode modes[] = {
+        { "mutex",             QueueBackend::MutexDeque,   Placement::None, false },
+        { "mutex",             QueueBackend::MutexDeque,   Placement::Core, false },
+        { "mutex",             QueueBackend::MutexDeque,   Placement::Node, false },
+        { "work-stealing",     QueueBackend::WorkStealing, Placement::None, false },
+        { "work-stealing",     QueueBackend::WorkStealing, Placement::Core, false },
+        { "work-stealing",     QueueBackend::WorkStealing, Placement::Node, false },
+        { "ws+shards por nodo", QueueBackend::WorkStealing, Placement::Core, true },
+        { "ws+shards por nodo", QueueBackend::WorkStealing, Placement::Node, true },
+    };
+    const char* placementNames[] = { "sin fijar", "nucleo", "nodo" };
+    const int RUN_MS = 500;
+
+    CpuTopology topo = CpuTopology::detect();
+    const int n = std::max(2, (int)topo.num_cpus());
+
+    std::cout << "\n===== BENCHMARK AFINIDAD (" << topo.num_nodes() << " nodo(s): " << topo.describe()
+        << "; " << n << "+" << n << " hilos) =====\n";
+    std::cout << "Backend           \tFijar     \tTareas/s\tOtro_nodo(%)\tRobos_entre_nodos\n";
+
+    for (const Mode& mode : modes) {
+        SimConfig cfg;
+        cfg.backend = mode.backend;
+        cfg.placement = mode.placement;
+        cfg.node_shards = mode.node_shards;
+        cfg.num_producers = n;
+        cfg.num_consumers = n;
+        cfg.run_ms = RUN_MS;
+        cfg.produce_interval_ms = 0;
+        cfg.simulate_processing = false;
+        cfg.verbose = false;
+
+        Simulation sim(cfg);
+        auto t0 = steady_clock::now();
+        sim.run();
+        double secs = duration<double>(steady_clock::now() - t0).count();
+
+        std::cout << std::left << std::setw(18) << mode.name << "\t"
+            << std::setw(10) << placementNames[(int)mode.placement] << std::right << "\t"
+            << std::fixed << std::setprecision(0) << std::setw(8) << sim.processed_total() / secs << "\t"
+            << std::setprecision(1) << std::setw(12) << 100.0 * sim.cross_node_fraction() << "\t"
+            << std::setw(17) << sim.remote_steals()
+            << (sim.pin_failures() > 0 ? "  (hilos sin fijar: " + std::to_string(sim.pin_failures()) + ")" : "")
+            << "\n";
+    }
+
+    std::cout << "=====================================================================\n\n";
+}
+
+// Hilos contra corrutinas con muchos clientes: cada productor produce una
+// tarea por segundo y hay un consumidor cada 5 productores (servicio real
+// de 50/100/150 ms), 3 s de producción. La memoria residente se mide al
+// detener la producción, con todos los clientes vivos.
+void benchmark_coroutines() {
+    struct Mode { const char* name; bool coroutines; int producers; };
+    const Mode modes[] = {
+        { "hilos",      false, 500 },
+        { "corrutinas", true,  500 },
+        { "corrutinas", true,  5000 },
+        { "corrutinas", true,  20000 },
+    };
+
+    std::cout << "\n===== BENCHMARK CORRUTINAS (1 tarea/s por productor, 3 s) =====\n";
+    std::cout << "Modo      \tProductores\tConsumidores\tTareas/s\tEspera_p99_ms(A/M/B)\tMemoria_MB\tMarcos_KB\n";
+
+    for (const Mode& mode : modes) {
+        SimConfig cfg;
+        cfg.coroutines = mode.coroutines;
+        cfg.num_producers = mode.producers;
+        cfg.num_consumers = mode.producers / 5;
+        cfg.max_queue = (size_t)mode.producers;
+        cfg.produce_interval_ms = 1000;
+        cfg.fixed_sequence = false; // a 1 tarea/s la secuencia fija tardaría 30 s
+        cfg.run_ms = 3000;
+        cfg.verbose = false;
+
+        Simulation sim(cfg);
+        try {
+            sim.run();
+        }
+        catch (const std::system_error& e) {
+            // Sin memoria o sin permiso para crear tantos hilos
+            std::cout << std::left << std::setw(10) << mode.name << std::right << "\t"
+                << std::setw(11) << mode.producers << "\tno se pudieron crear los hilos: " << e.what() << "\n";
+            continue;
+        }
+
+        std::ostringstream p99;
+        p99 << std::fixed << std::setprecision(1);
+        for (size_t c = 0; c < NUM_CLASSES; ++c) {
+            p99 << sim.wait_histogram(class_type(c)).percentile(0.99) / 1000.0 << (c + 1 < NUM_CLASSES ? "/" : "");
+        }
+
+        double secs = sim.elapsed_seconds();
+        std::cout << std::left << std::setw(10) << mode.name << std::right << "\t"
+            << std::setw(11) << cfg.num_producers << "\t" << std::setw(12) << cfg.num_consumers << "\t"
+            << std::fixed << std::setprecision(0) << std::setw(8) << (secs > 0 ? sim.processed_total() / secs : 0.0) << "\t"
+            << std::setw(20) << p99.str() << "\t"
+            << std::setprecision(1) << std::setw(10) << sim.resident_kb_at_stop() / 1024.0 << "\t"
+            << std::setw(9) << (mode.coroutines ? Simulation::coroutine_frame_bytes() / 1024 : 0) << "\n";
+    }
+
+    std::cout << "=====================================================================\n\n";
+}
+
+// Plazos con y sin desalojo bajo sobrecarga (reloj virtual, 60 s): las
+// llegadas duplican la capacidad de los consumidores. Sin desalojo se
+// procesan tareas que ya vencieron; con desalojo ese tiempo queda para
+// tareas que todavía sirven. "A tiempo" son las procesadas antes de su
+// plazo.
+void benchmark_expiry() {
+    struct Mode { const char* name; bool deadlines; bool evict; int cancel_pct; };
+    const Mode modes[] = {
+        { "sin plazos",          false, false, 0 },
+        { "plazos, sin desalojo", true, false, 0 },
+        { "plazos + desalojo",   true,  true,  0 },
+        { "desalojo + 10% canc.", true, true,  10 },
+    };
+
+    SimConfig base;
+    base.virtual_clock = true;
+    base.verbose = false;
+    base.run_ms = 60000;
+    base.max_queue = 200;
+    base.produce_interval_ms = 100; // 50 tareas/s contra ~27/s de servicio
+    const std::array<int, NUM_CLASSES> ttl{ 1000, 2000, 4000 };
+
+    std::cout << "\n===== BENCHMARK PLAZOS (reloj virtual, 60 s, plazos A/M/B = "
+        << ttl[0] << "/" << ttl[1] << "/" << ttl[2] << " ms) =====\n";
+    std::cout << "Modo                \tTareas/s\tA_tiempo/s\tVencidas(A/M/B)\tCanceladas\tEspera_p99_ms(A/M/B)\n";
+
+    for (const Mode& mode : modes) {
+        SimConfig cfg = base;
+        if (mode.deadlines) cfg.ttl_ms = ttl;
+        cfg.evict_expired = mode.evict;
+        cfg.cancel_pct = mode.cancel_pct;
+
+        Simulation sim(cfg);
+        sim.run();
+
+        long long late = 0, cancelled = 0;
+        std::ostringstream expired, p99;
+        p99 << std::fixed << std::setprecision(1);
+        for (size_t c = 0; c < NUM_CLASSES; ++c) {
+            late += sim.late(class_type(c));
+            cancelled += sim.cancelled(class_type(c));
+            expired << sim.expired(class_type(c)) << (c + 1 < NUM_CLASSES ? "/" : "");
+            p99 << sim.wait_histogram(class_type(c)).percentile(0.99) / 1000.0 << (c + 1 < NUM_CLASSES ? "/" : "");
+        }
+
+        double secs = sim.elapsed_seconds();
+        std::cout << std::left << std::setw(20) << mode.name << std::right << "\t"
+            << std::fixed << std::setprecision(1) << std::setw(8) << (secs > 0 ? sim.processed_total() / secs : 0.0) << "\t";
+        if (mode.deadlines) std::cout << std::setw(10) << (secs > 0 ? (sim.processed_total() - late) / secs : 0.0);
+        else                std::cout << std::setw(10) << "-";
+        std::cout << "\t" << std::setw(15) << expired.str() << "\t" << std::setw(10) << cancelled
+            << "\t" << p99.str() << "\n";
+    }
+
+    std::cout << "=====================================================================\n\n";
+}
+
+// --check-expiry: comprueba la rueda de plazos (timing_wheel.h) avanzando
+// en límites de tick como el expirador y termina con código 1 si algo
+// falla. Casos: un plazo a mitad de tick, uno justo en un límite, uno ya
+// vencido al anotarlo y uno una vuelta entera más adelante salen en el
+// primer límite en o después de su vencimiento, no una vuelta tarde.
+bool check_expiry() {
+    const long long TICK = 10000;
+    const std::size_t SLOTS = 1024;
+    bool ok = true;
+    auto expect_fires = [&](const char* what, long long now0, long long when, long long expected) {
+        TimingWheel<int> wheel(SLOTS, TICK);
+        wheel.advance(now0, [](int) {});
+        wheel.add(when, 1);
+        long long fired_at = -1;
+        for (long long now = now0 + TICK; fired_at < 0 && now <= when + 2 * (long long)SLOTS * TICK; now += TICK) {
+            if (wheel.advance(now, [](int) {}) > 0) fired_at = now;
+        }
+        if (fired_at != expected) {
+            std::cerr << "FALLA: " << what << ": vencio en " << fired_at << " us, se esperaba " << expected << "\n";
+            ok = false;
+        }
+    };
+
+    expect_fires("plazo a mitad de tick", 0, 15000, 20000);
+    expect_fires("plazo a mitad de un tick posterior", 10000, 45000, 50000);
+    expect_fires("plazo en un limite de tick", 10000, 30000, 30000);
+    expect_fires("plazo ya vencido", 50000, 15000, 60000);
+    expect_fires("plazo a mas de una vuelta", 0, (long long)SLOTS * TICK + 5000, ((long long)SLOTS + 1) * TICK);
+
+    std::cout << "Rueda de plazos: " << (ok ? "OK" : "CON FALLAS") << "\n";
+    return ok;
+}
+
+// Escalado con trabajo de CPU real: cada kernel con 1 consumidor, la mitad
+// de las CPUs, todas y el doble (servicio de 2/4/6 ms por clase, cola
+// siempre llena). "Escala" es el throughput contra el de 1 consumidor y
+// "Servicio" el p50 de B contra los 6 ms calibrados: con dormir escala
+// con los consumidores, con CPU se frena en los núcleos y con memoria
+// antes, cuando se satura el ancho de banda.
+void benchmark_workloads() {
+    const Workload kinds[] = { Workload::Sleep, Workload::Hash, Workload::Cache, Workload::Memory };
+    const int RUN_MS = 1000;
+
+    const int cpus = std::max(1, (int)CpuTopology::detect().num_cpus());
+    std::vector<int> counts = { 1 };
+    if (cpus / 2 > 1) counts.push_back(cpus / 2);
+    if (cpus > 1) counts.push_back(cpus);
+    counts.push_back(cpus * 2);
+
+    std::cout << "\n===== BENCHMARK TRABAJO DE CPU (" << cpus << " CPU(s), servicio 2/4/6 ms) =====\n";
+    std::cout << "Kernel  \tConsumidores\tTareas/s\tEscala(x)\tServicio_p50_B_ms\n";
+
+    for (Workload w : kinds) {
+        double single = 0;
+        for (int n : counts) {
+            SimConfig cfg;
+            cfg.workload = w;
+            cfg.num_consumers = n;
+            cfg.num_producers = n;
+            cfg.max_queue = (size_t)std::max(64, 8 * n);
+            cfg.processing_ms = { 2, 4, 6 };
+            cfg.produce_interval_ms = 0;
+            cfg.fixed_sequence = false;
+            cfg.run_ms = RUN_MS;
+            cfg.verbose = false;
+
+            Simulation sim(cfg);
+            sim.run();
+
+            double rate = sim.processed_total() / sim.elapsed_seconds();
+            if (n == 1) single = rate;
+            std::cout << std::left << std::setw(8) << workload_name(w) << std::right << "\t"
+                << std::setw(12) << n << "\t"
+                << std::fixed << std::setprecision(0) << std::setw(8) << rate << "\t"
+                << std::setprecision(2) << std::setw(9) << (single > 0 ? rate / single : 0.0) << "\t"
+                << std::setprecision(1) << std::setw(17) << sim.service_histogram('B').percentile(0.50) / 1000.0 << "\n";
+        }
+    }
+
+    std::cout << "=====================================================================\n\n";
+}
+
+// Puntaje de toda la cola con peso por tarea: arreglo de Task con
+// duration_cast por elemento (como el recorrido lineal original) contra la
+// cola SoA escalar y con AVX2. Cada fila es el tiempo de elegir la mejor
+// tarea en una cola de esa profundidad, en distintos instantes; se
+// verifica que las tres elijan siempre la misma.
+void benchmark_scoring() {
+    const size_t depths[] = { 1000, 10000, 100000 };
+    const int PICKS = 200;
+    const double SPREAD = 0.5;
+
+    std::cout << "\n===== BENCHMARK PUNTAJE (aging con peso por tarea, AVX2: "
+        << (WeightedAgingQueue::simd_available() ? "si" : "no") << ") =====\n";
+    std::cout << "Profundidad\tAoS(us/op)\tSoA(us/op)\tSoA_AVX2(us/op)\tAoS/AVX2(x)\tMismas_elecciones\n";
+
+    for (size_t depth : depths) {
+        std::mt19937 gen(42);
+        std::discrete_distribution<int> dist({ 10, 30, 60 });
+        std::uniform_real_distribution<float> weight((float)(1 - SPREAD), (float)(1 + SPREAD));
+        const char types[] = { 'A', 'M', 'B' };
+
+        // Llegadas cada 100 us; se elige en instantes posteriores, cuando el
+        // aging ya pesa más que la prioridad base
+        auto origin = steady_clock::now();
+        LinearWeightedAgingQueue linear(200.0);
+        WeightedAgingQueue soa(PolicyParams{});
+        for (size_t i = 0; i < depth; ++i) {
+            Task t{ types[dist(gen)], (int)i, origin + microseconds(100) * (long long)i };
+            t.weight = weight(gen);
+            linear.push(t, origin);
+            soa.push(t);
+        }
+        std::vector<steady_clock::time_point> when(PICKS);
+        for (int k = 0; k < PICKS; ++k) when[k] = origin + microseconds(100) * (long long)depth + milliseconds(7 * k);
+
+        std::vector<int> pickedAos(PICKS), pickedScalar(PICKS), pickedSimd(PICKS);
+        auto t0 = steady_clock::now();
+        for (int k = 0; k < PICKS; ++k) pickedAos[k] = linear.peek(when[k]).id;
+        auto t1 = steady_clock::now();
+        for (int k = 0; k < PICKS; ++k) pickedScalar[k] = soa.peek(when[k], ScoreKernel::Scalar).id;
+        auto t2 = steady_clock::now();
+        for (int k = 0; k < PICKS; ++k) pickedSimd[k] = soa.peek(when[k], ScoreKernel::Simd).id;
+        auto t3 = steady_clock::now();
+
+        double usAos = duration<double, std::micro>(t1 - t0).count() / PICKS;
+        double usScalar = duration<double, std::micro>(t2 - t1).count() / PICKS;
+        double usSimd = duration<double, std::micro>(t3 - t2).count() / PICKS;
+        bool same = pickedAos == pickedScalar && pickedScalar == pickedSimd;
+
+        std::cout << std::setw(11) << depth << "\t"
+            << std::fixed << std::setprecision(1)
+            << std::setw(10) << usAos << "\t"
+            << std::setw(10) << usScalar << "\t"
+            << std::setw(15) << usSimd << "\t"
+            << std::setw(11) << (usSimd > 0 ? usAos / usSimd : 0.0) << "\t"
+            << (same ? "SI" : "NO") << "\n";
+    }
+
+    std::cout << "=============================================================\n\n";
+}
+
+// Throughput de la cola en memoria compartida sin pausas de producción ni
+// de procesamiento: backend mutex y shm dentro de un proceso, y después
+// este proceso como consumidor con K procesos productores (se lanza este
+// mismo ejecutable con --shm-role=producer). En el caso multiproceso el
+// tiempo incluye el arranque de los productores.
+void benchmark_shm(const std::string& exe) {
+    const int RUN_MS = 500;
+    const int CONSUMERS = 2;
+    const int processCounts[] = { 1, 2, 4 };
+#ifdef _WIN32
+    const char* devNull = "NUL";
+#else
+    const char* devNull = "/dev/null";
+#endif
+
+    std::cout << "\n===== BENCHMARK MEMORIA COMPARTIDA (" << CONSUMERS << " consumidores) =====\n";
+    std::cout << "Modo                         \tProductores\tTareas/s\tEspera_p50_B_ms\n";
+
+    auto base = [&] {
+        SimConfig cfg;
+        cfg.num_consumers = CONSUMERS;
+        cfg.max_queue = 256;
+        cfg.run_ms = RUN_MS;
+        cfg.produce_interval_ms = 0;
+        cfg.simulate_processing = false;
+        cfg.fixed_sequence = false;
+        cfg.verbose = false;
+        cfg.shm_name = "starvation_bench";
+        return cfg;
+    };
+    auto row = [](const char* mode, int producers, Simulation& sim) {
+        std::cout << std::left << std::setw(29) << mode << std::right << "\t"
+            << std::setw(11) << producers << "\t"
+            << std::fixed << std::setprecision(0) << std::setw(8) << sim.processed_total() / sim.elapsed_seconds() << "\t"
+            << std::setprecision(3) << std::setw(15) << sim.wait_histogram('B').percentile(0.50) / 1000.0 << "\n";
+    };
+
+    for (QueueBackend b : { QueueBackend::MutexDeque, QueueBackend::SharedMemory }) {
+        SimConfig cfg = base();
+        cfg.backend = b;
+        cfg.num_producers = 2;
+        Simulation sim(cfg);
+        sim.run();
+        row(b == QueueBackend::MutexDeque ? "mutex, 1 proceso" : "shm, 1 proceso", cfg.num_producers, sim);
+    }
+
+    for (int k : processCounts) {
+        SimConfig cfg = base();
+        cfg.backend = QueueBackend::SharedMemory;
+        cfg.shm_role = ShmRole::Consumer;
+        cfg.shm_producers = k;
+        Simulation sim(cfg); // crea el segmento antes de lanzar a los productores
+
+        std::string cmd = "\"" + exe + "\" --backend=shm --shm-role=producer --shm-name=" + cfg.shm_name +
+            " --producers=1 --interval-ms=0 --run-ms=" + std::to_string(RUN_MS) +
+            " --fixed-sequence=0 > " + devNull;
+        std::vector<std::thread> spawned;
+        for (int i = 0; i < k; ++i) {
+            spawned.emplace_back([cmd] {
+                if (std::system(cmd.c_str()) != 0) std::cerr << "fallo el proceso productor\n";
+                });
+        }
+        sim.run();
+        for (auto& t : spawned) t.join();
+
+        std::string mode = "shm, consumidor + " + std::to_string(k) + " proc.";
+        row(mode.c_str(), k, sim);
+    }
+
+    std::cout << "=============================================================\n\n";
+}
+
+// ----- Escenarios configurables y barrido de parámetros -----
+
+// Parámetros "clave=valor" de la línea de comandos (--clave=v1,v2,...) y de
+// los archivos de --config, en el orden en que aparecieron. Con --sweep
+// cada clave puede tener varios valores y se ejecuta el producto cartesiano.
+using ParamList = std::vector<std::pair<std::string, std::vector<std::string>>>;
+
+const char* const PARAM_KEYS[] = {
+    "backend", "producers", "consumers", "max-queue", "run-ms", "interval-ms",
+    "dist", "aging-ms", "proc-ms", "batch", "seed", "latency-csv",
+    "policy", "share", "deadline-ms", "adaptive", "target-ms", "control-ms",
+    "burst-period-ms", "burst-ms", "quiet-interval-ms",
+    "elastic", "min-consumers", "max-consumers", "scale-ms",
+    "overflow", "enqueue-timeout-ms", "admit-pct",
+    "pin", "cpus", "node-shards", "coroutines", "workers", "fixed-sequence",
+    "record-trace", "replay-trace", "replay-speed", "ttl-ms", "evict", "cancel-pct",
+    "workload", "weight-spread", "shm-name", "shm-role", "shm-producers"
+};
+
+bool is_param_key(const std::string& key) {
+    for (const char* k : PARAM_KEYS) {
+        if (key == k) return true;
+    }
+    return false;
+}
+
+std::string trim(const std::string& s) {
+    size_t first = s.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return "";
+    return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, sep)) parts.push_back(trim(item));
+    return parts;
+}
+
+int parse_int(const std::string& key, const std::string& v, int min) {
+    size_t used = 0;
+    int n = 0;
+    try {
+        n = std::stoi(v, &used);
+    }
+    catch (const std::exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != v.size() || n < min) {
+        throw std::invalid_argument(key + ": valor invalido '" + v + "'");
+    }
+    return n;
+}
+
+double parse_double(const std::string& key, const std::string& v, double min) {
+    size_t used = 0;
+    double d = 0;
+    try {
+        d = std::stod(v, &used);
+    }
+    catch (const std::exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != v.size() || d < min) {
+        throw std::invalid_argument(key + ": valor invalido '" + v + "'");
+    }
+    return d;
+}
+
+// Tres enteros "A:M:B" (distribución o tiempos de servicio por clase)
+std::array<int, NUM_CLASSES> parse_per_class(const std::string& key, const std::string& v, int min) {
+    std::vector<std::string> parts = split(v, ':');
+    if (parts.size() != NUM_CLASSES) {
+        throw std::invalid_argument(key + ": se esperaba A:M:B, no '" + v + "'");
+    }
+    std::array<int, NUM_CLASSES> out{};
+    for (size_t c = 0; c < NUM_CLASSES; ++c) {
+        out[c] = parse_int(key, parts[c], min);
+    }
+    return out;
+}
+
+void apply_param(SimConfig& cfg, const std::string& key, const std::string& v) {
+    if (key == "backend") {
+        if (v == "mutex")              cfg.backend = QueueBackend::MutexDeque;
+        else if (v == "lockfree")      cfg.backend = QueueBackend::LockFreeRing;
+        else if (v == "work-stealing") cfg.backend = QueueBackend::WorkStealing;
+        else if (v == "shm")           cfg.backend = QueueBackend::SharedMemory;
+        else throw std::invalid_argument("backend: se esperaba mutex, lockfree, work-stealing o shm");
+    }
+    else if (key == "shm-name") cfg.shm_name = v;
+    else if (key == "shm-role") {
+        if (v == "both")          cfg.shm_role = ShmRole::Both;
+        else if (v == "producer") cfg.shm_role = ShmRole::Producer;
+        else if (v == "consumer") cfg.shm_role = ShmRole::Consumer;
+        else throw std::invalid_argument("shm-role: se esperaba both, producer o consumer");
+    }
+    else if (key == "shm-producers") cfg.shm_producers = parse_int(key, v, 1);
+    else if (key == "producers")   cfg.num_producers = parse_int(key, v, 1);
+    else if (key == "consumers")   cfg.num_consumers = parse_int(key, v, 1);
+    else if (key == "max-queue")   cfg.max_queue = (size_t)parse_int(key, v, 1);
+    else if (key == "run-ms")      cfg.run_ms = parse_int(key, v, 0);
+    else if (key == "interval-ms") cfg.produce_interval_ms = parse_int(key, v, 0);
+    else if (key == "dist") {
+        cfg.weights = parse_per_class(key, v, 0);
+        if (cfg.weights[0] + cfg.weights[1] + cfg.weights[2] == 0) {
+            throw std::invalid_argument("dist: al menos una clase debe tener peso");
+        }
+    }
+    else if (key == "aging-ms") {
+        cfg.aging_interval_ms = parse_int(key, v, 1);
+    }
+    else if (key == "proc-ms") cfg.processing_ms = parse_per_class(key, v, 0);
+    else if (key == "batch") {
+        cfg.producer_batch = parse_int(key, v, 1);
+        cfg.consumer_batch = cfg.producer_batch;
+    }
+    else if (key == "seed")        cfg.seed = (unsigned)parse_int(key, v, 0);
+    else if (key == "latency-csv") cfg.latency_csv = v;
+    else if (key == "policy") {
+        if (v == "strict")      cfg.policy = SchedPolicy::Strict;
+        else if (v == "aging")  cfg.policy = SchedPolicy::Aging;
+        else if (v == "wfq")    cfg.policy = SchedPolicy::WeightedFair;
+        else if (v == "drr")    cfg.policy = SchedPolicy::DeficitRoundRobin;
+        else if (v == "edf")    cfg.policy = SchedPolicy::EarliestDeadline;
+        else if (v == "weighted") cfg.policy = SchedPolicy::WeightedAging;
+        else throw std::invalid_argument("policy: se esperaba strict, aging, wfq, drr, edf o weighted");
+    }
+    else if (key == "share")       cfg.share = parse_per_class(key, v, 1);
+    else if (key == "deadline-ms") cfg.deadline_ms = parse_per_class(key, v, 0);
+    else if (key == "adaptive")    cfg.adaptive_aging = parse_int(key, v, 0) != 0;
+    else if (key == "target-ms")   cfg.aging_control.target_ms = parse_per_class(key, v, 1);
+    else if (key == "control-ms")  cfg.aging_control.period_ms = parse_int(key, v, 1);
+    else if (key == "burst-period-ms")   cfg.burst_period_ms = parse_int(key, v, 0);
+    else if (key == "burst-ms")          cfg.burst_ms = parse_int(key, v, 0);
+    else if (key == "quiet-interval-ms") cfg.quiet_interval_ms = parse_int(key, v, 0);
+    else if (key == "elastic")       cfg.elastic = parse_int(key, v, 0) != 0;
+    else if (key == "min-consumers") cfg.pool.min_size = parse_int(key, v, 1);
+    else if (key == "max-consumers") cfg.pool.max_size = parse_int(key, v, 1);
+    else if (key == "scale-ms")      cfg.scale_interval_ms = parse_int(key, v, 1);
+    else if (key == "overflow") {
+        if (v == "block")                   cfg.overflow = OverflowPolicy::Block;
+        else if (v == "drop-newest")        cfg.overflow = OverflowPolicy::DropNewest;
+        else if (v == "drop-oldest-lowest") cfg.overflow = OverflowPolicy::DropOldestLowest;
+        else if (v == "reject-by-class")    cfg.overflow = OverflowPolicy::RejectByClass;
+        else throw std::invalid_argument("overflow: se esperaba block, drop-newest, drop-oldest-lowest o reject-by-class");
+    }
+    else if (key == "enqueue-timeout-ms") cfg.enqueue_timeout_ms = parse_int(key, v, 0);
+    else if (key == "admit-pct")          cfg.admit_pct = parse_per_class(key, v, 1);
+    else if (key == "pin")         cfg.placement = parse_placement(v);
+    else if (key == "cpus") {
+        // Rangos separados por ':' (la coma separa valores de --sweep)
+        try {
+            cfg.cpus = parse_cpu_list(v, ':');
+        }
+        catch (const std::logic_error&) {
+            throw std::invalid_argument("cpus: se esperaba una lista como 0-3:8-11");
+        }
+    }
+    else if (key == "node-shards") cfg.node_shards = parse_int(key, v, 0) != 0;
+    else if (key == "coroutines")  cfg.coroutines = parse_int(key, v, 0) != 0;
+    else if (key == "workers")     cfg.coro_workers = parse_int(key, v, 1);
+    else if (key == "fixed-sequence") cfg.fixed_sequence = parse_int(key, v, 0) != 0;
+    else if (key == "record-trace") cfg.record_trace = v;
+    else if (key == "replay-trace") cfg.replay_trace = v;
+    else if (key == "replay-speed") cfg.replay_speed = parse_double(key, v, 0);
+    else if (key == "weight-spread") {
+        cfg.weight_spread = parse_double(key, v, 0);
+        if (cfg.weight_spread >= 1) throw std::invalid_argument("weight-spread: se esperaba un valor en [0, 1)");
+    }
+    else if (key == "ttl-ms")      cfg.ttl_ms = parse_per_class(key, v, 0);
+    else if (key == "evict")       cfg.evict_expired = parse_int(key, v, 0) != 0;
+    else if (key == "workload")    cfg.workload = parse_workload(v);
+    else if (key == "cancel-pct") {
+        cfg.cancel_pct = parse_int(key, v, 0);
+        if (cfg.cancel_pct > 100) throw std::invalid_argument("cancel-pct: debe estar entre 0 y 100");
+    }
+    else throw std::invalid_argument("clave desconocida: " + key);
+}
+
+// Agrega (o reemplaza) una clave; la última aparición gana
+void set_param(ParamList& params, const std::string& key, const std::string& values) {
+    if (!is_param_key(key)) throw std::invalid_argument("clave desconocida: " + key);
+    std::vector<std::string> list = split(values, ',');
+    if (list.empty()) throw std::invalid_argument(key + ": sin valores");
+    for (auto& p : params) {
+        if (p.first == key) {
+            p.second = list;
+            return;
+        }
+    }
+    params.emplace_back(key, list);
+}
+
+// Archivo de escenario: una línea "clave=valor[,valor...]" por parámetro,
+// las líneas vacías y las que empiezan con '#' se ignoran
+void load_config(const std::string& path, ParamList& params) {
+    std::ifstream in(path);
+    if (!in) throw std::invalid_argument("no se pudo abrir " + path);
+
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            throw std::invalid_argument(path + ":" + std::to_string(lineNo) + ": falta '='");
+        }
+        set_param(params, trim(line.substr(0, eq)), line.substr(eq + 1));
+    }
+}
+
+// "dir/lat.csv" -> "dir/lat_c<config>_t<trial>.csv" (el sufijo va antes de
+// la extensión, si la hay)
+std::string sweep_path(const std::string& path, size_t combo, int trial) {
+    std::string suffix = "_c" + std::to_string(combo) + "_t" + std::to_string(trial);
+    size_t slash = path.find_last_of("/\\");
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return path + suffix;
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
+// Ejecuta 'trials' repeticiones de cada combinación de parámetros y escribe
+// una fila CSV por ejecución: throughput, profundidad máxima de la cola y
+// percentiles de espera por clase. La semilla de la repetición t es seed + t
+// (solo fija el resultado en modo --virtual). Con --latency-csv o
+// --record-trace cada ejecución escribe su propio archivo, con la
+// configuración y la repetición de su fila en el nombre (ver sweep_path).
+void run_sweep(const SimConfig& base, const ParamList& params, int trials, std::ostream& out) {
+    size_t combos = 1;
+    for (const auto& p : params) combos *= p.second.size();
+
+    out << "config,trial";
+    for (const auto& p : params) out << "," << p.first;
+    out << ",procesadas_A,procesadas_M,procesadas_B,segundos,tareas_por_s,profundidad_max"
+        << ",rechazadas_A,rechazadas_M,rechazadas_B,descartadas_A,descartadas_M,descartadas_B"
+        << ",vencidas_A,vencidas_M,vencidas_B,canceladas_A,canceladas_M,canceladas_B";
+    for (size_t c = 0; c < NUM_CLASSES; ++c) {
+        char t = class_type(c);
+        for (const char* q : { "p50", "p90", "p99", "p999", "max" }) {
+            out << ",espera_" << t << "_" << q << "_ms";
+        }
+    }
+    out << "\n";
+
+    for (size_t combo = 0; combo < combos; ++combo) {
+        // Índice mixto: la última clave es la que cambia más rápido
+        std::vector<std::string> values(params.size());
+        size_t rest = combo;
+        for (size_t k = params.size(); k-- > 0;) {
+            values[k] = params[k].second[rest % params[k].second.size()];
+            rest /= params[k].second.size();
+        }
+
+        SimConfig cfg = base;
+        cfg.verbose = false;
+        for (size_t k = 0; k < params.size(); ++k) {
+            apply_param(cfg, params[k].first, values[k]);
+        }
+        const unsigned baseSeed = cfg.seed;
+        const std::string latencyCsv = cfg.latency_csv;
+        const std::string recordTrace = cfg.record_trace;
+
+        for (int trial = 0; trial < trials; ++trial) {
+            cfg.seed = baseSeed + (unsigned)trial;
+            if (!latencyCsv.empty()) cfg.latency_csv = sweep_path(latencyCsv, combo, trial);
+            if (!recordTrace.empty()) cfg.record_trace = sweep_path(recordTrace, combo, trial);
+            std::cerr << "[barrido] configuracion " << combo + 1 << "/" << combos
+                << ", repeticion " << trial + 1 << "/" << trials << "\n";
+
+            with_policy(cfg.policy, [&](auto tag) {
+                BasicSimulation<typename decltype(tag)::type> sim(cfg);
+                sim.run();
+
+                double secs = sim.elapsed_seconds();
+                out << combo << "," << trial;
+                for (const auto& v : values) out << "," << v;
+                out << "," << sim.processed('A') << "," << sim.processed('M') << "," << sim.processed('B')
+                    << "," << std::fixed << std::setprecision(3) << secs
+                    << "," << std::setprecision(1) << (secs > 0 ? sim.processed_total() / secs : 0.0)
+                    << "," << sim.max_depth();
+                for (size_t c = 0; c < NUM_CLASSES; ++c) out << "," << sim.rejected(class_type(c));
+                for (size_t c = 0; c < NUM_CLASSES; ++c) out << "," << sim.shed(class_type(c));
+                for (size_t c = 0; c < NUM_CLASSES; ++c) out << "," << sim.expired(class_type(c));
+                for (size_t c = 0; c < NUM_CLASSES; ++c) out << "," << sim.cancelled(class_type(c));
+                for (size_t c = 0; c < NUM_CLASSES; ++c) {
+                    out << "," << Simulation::percentile_row(sim.wait_histogram(class_type(c)), ",");
+                }
+                out << "\n";
+                out.flush();
+                });
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    SimConfig cfg;
+    ParamList params;
+    bool sweep = false;
+    bool benchPolicies = false;
+    int trials = 1;
+    std::string outPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--bench-scheduler") {
+            benchmark_scheduler();
+            return 0;
+        }
+        if (arg == "--bench-backend") {
+            benchmark_backends();
+            return 0;
+        }
+        if (arg == "--bench-batch") {
+            benchmark_batch();
+            return 0;
+        }
+
+        if (arg == "--bench-policies") {
+            // Las 6 políticas con las mismas llegadas (reloj virtual); acepta
+            // los mismos parámetros --clave=valor que la simulación
+            benchPolicies = true;
+            cfg.virtual_clock = true;
+        }
+        else if (arg == "--bench-aging") {
+            benchmark_adaptive_aging();
+            return 0;
+        }
+        else if (arg == "--bench-elastic") {
+            benchmark_elastic();
+            return 0;
+        }
+        else if (arg == "--bench-affinity") {
+            benchmark_affinity();
+            return 0;
+        }
+        else if (arg == "--bench-coroutines") {
+            benchmark_coroutines();
+            return 0;
+        }
+        else if (arg == "--bench-expiry") {
+            benchmark_expiry();
+            return 0;
+        }
+        else if (arg == "--check-expiry") {
+            return check_expiry() ? 0 : 1;
+        }
+        else if (arg == "--bench-workload") {
+            benchmark_workloads();
+            return 0;
+        }
+        else if (arg == "--bench-scoring") {
+            benchmark_scoring();
+            return 0;
+        }
+        else if (arg == "--bench-shm") {
+            try {
+                benchmark_shm(argv[0]);
+            }
+            catch (const std::system_error& e) {
+                std::cerr << "Error del sistema: " << e.what() << "\n";
+                return 1;
+            }
+            return 0;
+        }
+        else if (arg == "--coroutines") {
+            // Productores y consumidores como corrutinas sobre pocos hilos
+            cfg.coroutines = true;
+        }
+        else if (arg == "--elastic") {
+            // Entre pool.min_size y pool.max_size consumidores según la carga
+            cfg.elastic = true;
+        }
+        else if (arg == "--adaptive-aging") {
+            // Ajustar aging_interval_ms según la espera de cada clase
+            cfg.adaptive_aging = true;
+        }
+        else if (arg == "--lockfree") {
+            cfg.backend = QueueBackend::LockFreeRing;
+        }
+        else if (arg == "--batch") {
+            // Productores y consumidores mueven hasta 4 tareas por toma del lock
+            cfg.producer_batch = 4;
+            cfg.consumer_batch = 4;
+        }
+        else if (arg == "--monitor-fast") {
+            // Monitor a 50 Hz; la cola completa solo se vuelca una vez por segundo
+            cfg.monitor_interval_ms = 20;
+            cfg.dump_queue_every = 50;
+        }
+        else if (arg == "--work-stealing") {
+            // Un consumidor por núcleo (al menos los 3 originales)
+            cfg.backend = QueueBackend::WorkStealing;
+            cfg.num_consumers = std::max(3, (int)std::thread::hardware_concurrency());
+        }
+        else if (arg == "--virtual") {
+            // Reloj simulado: misma lógica, termina en milisegundos
+            cfg.virtual_clock = true;
+        }
+        else if (arg == "--sweep") {
+            // Una fila CSV por combinación de parámetros y repetición
+            sweep = true;
+        }
+        else if (arg.rfind("--", 0) == 0 && arg.find('=') != std::string::npos) {
+            std::string key = arg.substr(2, arg.find('=') - 2);
+            std::string value = arg.substr(arg.find('=') + 1);
+            try {
+                if (key == "config")      load_config(value, params);
+                else if (key == "trials") trials = parse_int(key, value, 1);
+                else if (key == "out")    outPath = value;
+                else                      set_param(params, key, value);
+            }
+            catch (const std::invalid_argument& e) {
+                std::cerr << "Error: " << e.what() << "\n";
+                return 1;
+            }
+        }
+        else {
+            std::cerr << "Opcion desconocida: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    try {
+        if (sweep) {
+            if (outPath.empty()) {
+                run_sweep(cfg, params, trials, std::cout);
+            }
+            else {
+                std::ofstream out(outPath);
+                if (!out) throw std::invalid_argument("no se pudo crear " + outPath);
+                run_sweep(cfg, params, trials, out);
+            }
+            return 0;
+        }
+
+        // Sin --sweep cada parámetro debe tener un solo valor
+        for (const auto& p : params) {
+            if (p.second.size() != 1) {
+                throw std::invalid_argument(p.first + ": varios valores requieren --sweep");
+            }
+            apply_param(cfg, p.first, p.second[0]);
+        }
+
+        if (benchPolicies) {
+            benchmark_policies(cfg);
+            return 0;
+        }
+
+        with_policy(cfg.policy, [&](auto tag) {
+            BasicSimulation<typename decltype(tag)::type> sim(cfg);
+            sim.run();
+            });
+    }
+    catch (const std::invalid_argument& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    catch (const std::system_error& e) {
+        std::cerr << "Error del sistema: " << e.what() << "\n";
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,54 @@
+// task.h
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+// Representa una tarea en la cola
+struct Task {
+    char type; // 'A', 'M', 'B'
+    int id;    // identificador único
+    std::chrono::steady_clock::time_point enqueue_time; // instante en que entró a la cola
+    int node = -1; // nodo NUMA del productor (-1 = desconocido, ver thread_affinity.h)
+    // Plazo: si no empezó a procesarse antes, la tarea ya no sirve y se
+    // descarta (max() = sin plazo)
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    // Peso del aging de esta tarea (política weighted, ver soa_queue.h)
+    float weight = 1.0f;
+};
+
+// Número de clases de tarea (A, M, B)
+constexpr std::size_t NUM_CLASSES = 3;
+
+// Índice de clase: A -> 0, M -> 1, B -> 2
+inline std::size_t class_index(char type) {
+    switch (type) {
+    case 'A': return 0;
+    case 'M': return 1;
+    }
+    return 2;
+}
+
+inline char class_type(std::size_t cls) {
+    static const char types[NUM_CLASSES] = { 'A', 'M', 'B' };
+    return types[cls];
+}
+
+inline int base_priority(char type) {
+    // A > M > B
+    switch (type) {
+    case 'A': return 3;
+    case 'M': return 2;
+    case 'B': return 1;
+    }
+    return 0;
+}
+
+// Parámetros de las políticas de planificación (scheduling_policies.h).
+// Cada política usa los que necesita.
+struct PolicyParams {
+    double aging_interval_ms = 200.0;                     // aging
+    std::array<int, NUM_CLASSES> share{ 3, 2, 1 };        // peso por clase (WFQ, DRR)
+    std::array<int, NUM_CLASSES> cost_ms{ 50, 100, 150 }; // servicio esperado (WFQ, DRR)
+    std::array<int, NUM_CLASSES> deadline_ms{ 250, 500, 1000 }; // plazo relativo (EDF)
+};
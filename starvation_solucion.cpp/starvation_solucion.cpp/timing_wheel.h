@@ -0,0 +1,97 @@
+// timing_wheel.h
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Rueda de temporizadores (hashed timing wheel) para los plazos de las
+// tareas.
+//
+// El tiempo se divide en ticks de tick_us y cada tick cae en una de
+// 'slots' ranuras (tick % slots). add() es O(1): anota el elemento en la
+// ranura del primer límite de tick en o después de su vencimiento (un
+// vencimiento a mitad de tick va al tick siguiente, que es el primero en
+// que advance() lo encuentra vencido). advance(now) recorre solo las
+// ranuras de los ticks que pasaron desde la última llamada y entrega los
+// elementos ya vencidos; los que caen en la misma ranura pero una vuelta
+// más adelante se quedan. Así vencer tareas cuesta lo que vence, no lo que
+// hay en cola, y cada elemento sale a lo sumo un tick tarde.
+//
+// Los tiempos son microsegundos desde un origen cualquiera (el inicio de
+// la ejecución). No es thread-safe: se usa con el lock de la cola.
+template <class T>
+class TimingWheel {
+public:
+    explicit TimingWheel(std::size_t slots = 1024, long long tick_us = 10000)
+        : slots_(slots), tick_us_(tick_us > 0 ? tick_us : 1) {
+    }
+
+    void clear() {
+        for (auto& s : slots_) s.clear();
+        size_ = 0;
+        current_ = 0;
+    }
+
+    // Elementos anotados que todavía no vencieron
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Vence en when_us. Si ya pasó, sale en el próximo advance().
+    void add(long long when_us, const T& item) {
+        // Hacia arriba: con floor, un vencimiento a mitad del tick actual
+        // quedaría en una ranura ya recorrida y esperaría una vuelta entera
+        long long tick = when_us > 0 ? (when_us + tick_us_ - 1) / tick_us_ : 0;
+        if (tick <= current_) tick = current_ + 1;
+        slots_[(std::size_t)(tick % (long long)slots_.size())].push_back({ when_us, item });
+        ++size_;
+    }
+
+    // Llama a on_expired(item) por cada elemento con vencimiento <= now_us.
+    // Devuelve cuántos vencieron.
+    template <class F>
+    std::size_t advance(long long now_us, F on_expired) {
+        long long target = now_us / tick_us_;
+        if (target <= current_ || size_ == 0) {
+            current_ = std::max(current_, target);
+            return 0;
+        }
+
+        // Después de una vuelta completa ya se miraron todas las ranuras
+        long long last = std::min(target, current_ + (long long)slots_.size());
+        std::size_t fired = 0;
+        for (long long tick = current_ + 1; tick <= last; ++tick) {
+            fired += expire_slot(slots_[(std::size_t)(tick % (long long)slots_.size())], now_us, on_expired);
+        }
+        current_ = target;
+        return fired;
+    }
+
+private:
+    struct Entry {
+        long long when_us;
+        T item;
+    };
+
+    template <class F>
+    std::size_t expire_slot(std::vector<Entry>& slot, long long now_us, F& on_expired) {
+        std::size_t kept = 0, fired = 0;
+        for (std::size_t i = 0; i < slot.size(); ++i) {
+            if (slot[i].when_us <= now_us) {
+                on_expired(slot[i].item);
+                ++fired;
+            }
+            else {
+                slot[kept++] = std::move(slot[i]); // una vuelta más adelante
+            }
+        }
+        slot.resize(kept);
+        size_ -= fired;
+        return fired;
+    }
+
+    std::vector<std::vector<Entry>> slots_;
+    long long tick_us_;
+    long long current_ = 0; // último tick procesado
+    std::size_t size_ = 0;
+};
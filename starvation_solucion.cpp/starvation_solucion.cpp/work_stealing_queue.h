@@ -0,0 +1,306 @@
+// work_stealing_queue.h
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "task.h"
+#include "aging_scheduler.h"
+#include "parking.h"
+
+// Colas por consumidor con robo de trabajo.
+//
+// Cada consumidor es dueño de un shard (AgingQueue + mutex propio, casi
+// nunca disputado) y los productores reparten las tareas en round-robin.
+// Cada shard publica en atómicos la cabeza de cada clase, y la cola guarda
+// además un resumen global: la cabeza más antigua de cada clase entre
+// todos los shards. En cada extracción un consumidor puntúa sin tomar
+// locks las cabezas de su shard y de unos pocos shards elegidos al azar
+// (no de todos: recorrerlos todos cuesta O(shards) lecturas de líneas que
+// escriben otros núcleos en cada extracción) y compara la mejor con el
+// puntaje del resumen. Solo si el resumen promete una cabeza mejor por
+// más de 'steal_slack' recorre todos los shards. Después atiende su
+// propio shard salvo que otra cabeza lo supere por más de 'steal_slack';
+// en ese caso, o si su shard está vacío, roba de ese shard.
+//
+// Así ninguna cabeza de ningún shard supera a la elegida por más de
+// steal_slack: con un margen menor que 1 una A esperando en cualquier
+// shard le gana a una M o B recién llegada (A > M > B) y una cabeza
+// envejecida se atiende con una tolerancia de steal_slack *
+// aging_interval_ms. El resumen solo baja al insertar; cuando la cabeza
+// más antigua sale queda viejo (promete de más) y el próximo recorrido
+// completo lo recalcula.
+//
+// Con 'shard_node' (nodo NUMA de cada shard) los shards se agrupan por
+// nodo: una tarea va a un shard del nodo donde se produjo (Task::node) y el
+// robo se hace en dos niveles con el mismo margen, primero dentro del nodo
+// y solo si la mejor cabeza de otro nodo supera a la del propio, fuera.
+// Los dos niveles miden el margen contra la mejor cabeza de todas, así que
+// la garantía de steal_slack sigue valiendo.
+class WorkStealingQueues {
+public:
+    WorkStealingQueues(std::size_t num_shards, std::size_t max_size,
+        double aging_interval_ms, std::vector<int> shard_node = {},
+        double steal_slack = 0.25)
+        : max_size_(max_size),
+        aging_interval_ms_(aging_interval_ms),
+        steal_slack_(steal_slack),
+        shard_node_(std::move(shard_node))
+    {
+        for (std::size_t i = 0; i < num_shards; ++i) {
+            shards_.push_back(std::make_unique<Shard>(aging_interval_ms));
+        }
+        shard_node_.resize(num_shards, 0);
+        for (std::size_t i = 0; i < num_shards; ++i) {
+            std::size_t node = (std::size_t)shard_node_[i];
+            if (node >= node_shards_.size()) node_shards_.resize(node + 1);
+            node_shards_[node].push_back(i);
+        }
+    }
+
+    bool try_push(const Task& t) {
+        // Reservar un lugar en el total (MAX_QUEUE sigue siendo global)
+        std::size_t c = count_.load(std::memory_order_relaxed);
+        do {
+            if (c >= max_size_) return false;
+        } while (!count_.compare_exchange_weak(c, c + 1, std::memory_order_acq_rel));
+
+        // Round-robin entre todos los shards, o entre los del nodo de la tarea
+        std::size_t next = next_shard_.fetch_add(1, std::memory_order_relaxed);
+        std::size_t idx = next % shards_.size();
+        if (node_shards_.size() > 1 && t.node >= 0 && (std::size_t)t.node < node_shards_.size() &&
+            !node_shards_[t.node].empty()) {
+            const auto& local = node_shards_[t.node];
+            idx = local[next % local.size()];
+        }
+        Shard& s = *shards_[idx];
+        {
+            std::lock_guard<std::mutex> lk(s.mtx);
+            s.queue.push(t);
+            s.publish();
+            std::size_t cls = class_index(t.type);
+            lower_oldest(cls, s.head_ticks[cls].load(std::memory_order_relaxed));
+        }
+        not_empty_.signal();
+        return true;
+    }
+
+    bool try_pop(std::size_t self, Task& out, std::chrono::steady_clock::time_point now) {
+        // Reintentos acotados: la vista global puede quedar vieja entre la
+        // lectura de las cabezas y el lock del shard elegido.
+        for (std::size_t attempt = 0; attempt <= shards_.size(); ++attempt) {
+            double localScore = 0, nodeScore = 0, globalScore = 0;
+            int localId = 0, nodeId = 0, globalId = 0;
+            bool hasLocal = best_head(*shards_[self], now, localScore, localId);
+
+            // Mejor cabeza entre los shards mirados y entre los del propio nodo
+            const std::size_t none = shards_.size();
+            std::size_t target = none, nodeTarget = none;
+            auto consider = [&](std::size_t i) {
+                double score = 0;
+                int id = 0;
+                if (!best_head(*shards_[i], now, score, id)) return;
+                if (target == none || score > globalScore ||
+                    (score == globalScore && id < globalId)) {
+                    globalScore = score;
+                    globalId = id;
+                    target = i;
+                }
+                if (shard_node_[i] == shard_node_[self] && (nodeTarget == none || score > nodeScore ||
+                    (score == nodeScore && id < nodeId))) {
+                    nodeScore = score;
+                    nodeId = id;
+                    nodeTarget = i;
+                }
+            };
+
+            // Muestra acotada: el propio shard, STEAL_SAMPLES del propio nodo
+            // al azar y uno de cualquier nodo. Se recorren todos si la muestra
+            // está vacía (para no dar la cola por vacía sin estarlo) o si el
+            // resumen promete una cabeza mejor que la vista.
+            consider(self);
+            const auto& local = node_shards_[shard_node_[self]];
+            for (std::size_t k = 0; k < STEAL_SAMPLES && local.size() > 1; ++k) {
+                consider(local[next_random() % local.size()]);
+            }
+            if (node_shards_.size() > 1) consider(next_random() % shards_.size());
+            double bound = 0;
+            bool any = oldest_bound(now, bound);
+            if (target == none || (any && bound > globalScore + steal_slack_)) {
+                std::int64_t seen[NUM_CLASSES];
+                for (std::size_t c = 0; c < NUM_CLASSES; ++c) seen[c] = oldest_[c].load(std::memory_order_relaxed);
+                for (std::size_t i = 0; i < shards_.size(); ++i) consider(i);
+                refresh_oldest(seen);
+            }
+            if (target == none) return false;
+
+            // Ambos niveles se comparan contra la mejor cabeza vista, no
+            // contra la del nodo: si no, la elegida podría quedar hasta
+            // 2 * steal_slack por debajo
+            if (nodeTarget != none && globalScore <= nodeScore + steal_slack_) {
+                target = nodeTarget;
+            }
+            if (hasLocal && globalScore <= localScore + steal_slack_) {
+                target = self;
+            }
+
+            Shard& s = *shards_[target];
+            {
+                std::lock_guard<std::mutex> lk(s.mtx);
+                if (s.queue.empty()) continue;
+                out = s.queue.pop_next(now);
+                s.publish();
+            }
+            if (target != self) steals_.fetch_add(1, std::memory_order_relaxed);
+            if (shard_node_[target] != shard_node_[self]) remote_steals_.fetch_add(1, std::memory_order_relaxed);
+
+            count_.fetch_sub(1, std::memory_order_acq_rel);
+            not_full_.signal();
+            return true;
+        }
+        return false;
+    }
+
+    // Inserción bloqueante; false si 'stop' se activó antes de insertar
+    bool push(const Task& t, const std::atomic<bool>& stop) {
+        return not_full_.wait_until([&] { return try_push(t); }, stop);
+    }
+
+    // Extracción bloqueante para el consumidor 'self'; false si 'stop' se activó
+    bool pop(std::size_t self, Task& out, const std::atomic<bool>& stop) {
+        return not_empty_.wait_until(
+            [&] { return try_pop(self, out, std::chrono::steady_clock::now()); }, stop);
+    }
+
+    void wake_all() {
+        not_full_.wake_all();
+        not_empty_.wake_all();
+    }
+
+    std::size_t size() const { return count_.load(std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+
+    std::size_t count(char type) const {
+        std::size_t total = 0;
+        for (const auto& s : shards_) {
+            total += s->class_count[class_index(type)].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    long long steals() const { return steals_.load(); }
+    // Robos de un shard de otro nodo (0 sin 'shard_node')
+    long long remote_steals() const { return remote_steals_.load(); }
+
+private:
+    static constexpr std::int64_t EMPTY = std::numeric_limits<std::int64_t>::max();
+    static constexpr std::size_t STEAL_SAMPLES = 2;
+
+    // xorshift32 por hilo para elegir los shards a mirar
+    static std::uint32_t next_random() {
+        thread_local std::uint32_t x = 2463534242u ^
+            (std::uint32_t)(std::uintptr_t)&x;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x;
+    }
+
+    struct alignas(64) Shard {
+        explicit Shard(double aging_interval_ms) : queue(aging_interval_ms) {}
+
+        std::mutex mtx;
+        AgingQueue queue;
+
+        // Vista global: cabeza de cada clase (EMPTY si no hay) y tamaños
+        std::atomic<std::int64_t> head_ticks[NUM_CLASSES] = { EMPTY, EMPTY, EMPTY };
+        std::atomic<int> head_id[NUM_CLASSES] = { 0, 0, 0 };
+        std::atomic<std::size_t> class_count[NUM_CLASSES] = { 0, 0, 0 };
+
+        // Se llama con 'mtx' tomado después de modificar 'queue'
+        void publish() {
+            for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+                const Task* h = queue.head(c);
+                head_ticks[c].store(h ? h->enqueue_time.time_since_epoch().count() : EMPTY,
+                    std::memory_order_relaxed);
+                head_id[c].store(h ? h->id : 0, std::memory_order_relaxed);
+                class_count[c].store(queue.count(class_type(c)), std::memory_order_relaxed);
+            }
+        }
+    };
+
+    // Con el mutex del shard tomado, después de publish(): baja el resumen
+    // de la clase si la cabeza del shard es más antigua
+    void lower_oldest(std::size_t c, std::int64_t ticks) {
+        std::int64_t cur = oldest_[c].load(std::memory_order_relaxed);
+        while (ticks < cur && !oldest_[c].compare_exchange_weak(cur, ticks, std::memory_order_relaxed)) {}
+    }
+
+    // Recalcula el resumen desde las cabezas publicadas. Si alguna inserción
+    // lo bajó después de leer 'seen', el CAS falla y queda ese valor.
+    void refresh_oldest(const std::int64_t (&seen)[NUM_CLASSES]) {
+        for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+            std::int64_t oldest = EMPTY;
+            for (const auto& s : shards_) oldest = std::min(oldest, s->head_ticks[c].load(std::memory_order_relaxed));
+            std::int64_t expected = seen[c];
+            if (oldest != expected) oldest_[c].compare_exchange_strong(expected, oldest, std::memory_order_relaxed);
+        }
+    }
+
+    // Mayor puntaje que puede tener una cabeza en algún shard según el
+    // resumen; false si el resumen no tiene ninguna
+    bool oldest_bound(std::chrono::steady_clock::time_point now, double& bound) const {
+        bool found = false;
+        for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+            std::int64_t ticks = oldest_[c].load(std::memory_order_relaxed);
+            if (ticks == EMPTY) continue;
+            Task probe{ class_type(c), 0,
+                std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(ticks)) };
+            double score = aging_score(probe, now, aging_interval_ms_);
+            if (!found || score > bound) bound = score;
+            found = true;
+        }
+        return found;
+    }
+
+    // Mejor cabeza publicada de un shard según la regla de aging
+    bool best_head(const Shard& s, std::chrono::steady_clock::time_point now,
+        double& bestScore, int& bestId) const {
+        bool found = false;
+        for (std::size_t c = 0; c < NUM_CLASSES; ++c) {
+            std::int64_t ticks = s.head_ticks[c].load(std::memory_order_relaxed);
+            if (ticks == EMPTY) continue;
+            Task probe{ class_type(c), s.head_id[c].load(std::memory_order_relaxed),
+                std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(ticks)) };
+            double score = aging_score(probe, now, aging_interval_ms_);
+            if (!found || score > bestScore || (score == bestScore && probe.id < bestId)) {
+                bestScore = score;
+                bestId = probe.id;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    const std::size_t max_size_;
+    const double aging_interval_ms_;
+    const double steal_slack_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::vector<int> shard_node_;                     // nodo de cada shard
+    std::vector<std::vector<std::size_t>> node_shards_; // shards de cada nodo
+
+    alignas(64) std::atomic<std::int64_t> oldest_[NUM_CLASSES] = { EMPTY, EMPTY, EMPTY }; // resumen global
+    alignas(64) std::atomic<std::size_t> count_{ 0 };
+    alignas(64) std::atomic<std::size_t> next_shard_{ 0 };
+    alignas(64) std::atomic<long long> steals_{ 0 };
+    std::atomic<long long> remote_steals_{ 0 };
+    ParkingSpot not_empty_;
+    ParkingSpot not_full_;
+};
@@ -0,0 +1,159 @@
+// workload_kernels.h
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Trabajo de CPU real para el procesamiento de las tareas, en lugar de
+// dormir: el consumidor ocupa un núcleo durante (aproximadamente) los ms de
+// su clase, así el throughput refleja contención por núcleos, caché y
+// memoria.
+//
+//   Workload::Sleep   sleep_for (la simulación original, no usa CPU)
+//   Workload::Hash    mezcla de enteros de 64 bits encadenada: solo ALU
+//   Workload::Memory  suma secuencial sobre un arreglo de 64 MB: limitado
+//                     por el ancho de banda de memoria, se degrada cuando
+//                     varios núcleos leen a la vez
+//   Workload::Cache   recorrido de punteros en 32 KB: latencia de L1/L2,
+//                     escala con los núcleos
+//
+// Cada kernel trabaja en unidades fijas (decenas de us). calibrate() mide
+// cuántas unidades entran en un ms con un solo hilo y la máquina libre;
+// run(ms) ejecuta esa cantidad. Con más consumidores que núcleos, o
+// compitiendo por la memoria, la misma cantidad de trabajo tarda más: esa
+// diferencia es lo que se quiere medir.
+enum class Workload { Sleep, Hash, Memory, Cache };
+
+// "sleep", "hash", "memory" o "cache"
+inline Workload parse_workload(const std::string& s) {
+    if (s == "sleep")  return Workload::Sleep;
+    if (s == "hash")   return Workload::Hash;
+    if (s == "memory") return Workload::Memory;
+    if (s == "cache")  return Workload::Cache;
+    throw std::invalid_argument("workload: se esperaba sleep, hash, memory o cache");
+}
+
+inline const char* workload_name(Workload w) {
+    switch (w) {
+    case Workload::Sleep:  return "sleep";
+    case Workload::Hash:   return "hash";
+    case Workload::Memory: return "memory";
+    case Workload::Cache:  return "cache";
+    }
+    return "?";
+}
+
+class WorkloadKernel {
+public:
+    explicit WorkloadKernel(Workload w) : kind_(w) {
+        if (kind_ == Workload::Memory) {
+            // Bastante más grande que la caché de último nivel
+            stream_.assign(MEMORY_BYTES / sizeof(std::uint64_t), 0);
+            for (std::size_t i = 0; i < stream_.size(); ++i) stream_[i] = i * 0x9E3779B97F4A7C15ull;
+        }
+        else if (kind_ == Workload::Cache) {
+            // Un solo ciclo que pasa por todas las posiciones, con saltos
+            // para que el prefetcher no lo adivine
+            std::vector<std::uint32_t> order(CACHE_SLOTS);
+            for (std::uint32_t i = 0; i < CACHE_SLOTS; ++i) order[i] = i;
+            std::uint64_t x = 0x2545F4914F6CDD1Dull;
+            for (std::uint32_t i = CACHE_SLOTS - 1; i > 0; --i) {
+                x = mix(x);
+                std::swap(order[i], order[(std::uint32_t)(x % (i + 1))]);
+            }
+            ring_.assign(CACHE_SLOTS, 0);
+            for (std::uint32_t i = 0; i < CACHE_SLOTS; ++i) ring_[order[i]] = order[(i + 1) % CACHE_SLOTS];
+        }
+    }
+
+    Workload kind() const { return kind_; }
+
+    // Mide unidades por ms durante ~'budget' (un hilo), en 5 rondas: se
+    // queda con la más rápida, las otras pueden haber sufrido
+    // interrupciones o la CPU todavía subiendo de frecuencia
+    void calibrate(std::chrono::milliseconds budget = std::chrono::milliseconds(100)) {
+        using namespace std::chrono;
+        if (kind_ == Workload::Sleep) return;
+        const int ROUNDS = 5;
+        std::uint64_t units = 0, sink = 0;
+        units_per_ms_ = 0;
+        for (int r = 0; r < ROUNDS; ++r) {
+            std::uint64_t first = units;
+            auto start = steady_clock::now();
+            auto end = start + budget / ROUNDS;
+            while (steady_clock::now() < end) {
+                for (int i = 0; i < 16; ++i) sink += unit(units++);
+            }
+            double ms = duration<double, std::milli>(steady_clock::now() - start).count();
+            units_per_ms_ = std::max(units_per_ms_, (double)(units - first) / ms);
+        }
+        sink_ = sink;
+    }
+
+    double units_per_ms() const { return units_per_ms_; }
+
+    // Duración de una unidad en us (según la calibración)
+    double unit_us() const { return units_per_ms_ > 0 ? 1000.0 / units_per_ms_ : 0; }
+
+    // Ejecuta el trabajo calibrado para 'ms'. 'seed' elige de dónde empieza
+    // (el id de la tarea: consumidores distintos leen zonas distintas).
+    // Devuelve un resumen del cálculo para que el compilador no lo elimine.
+    std::uint64_t run(double ms, std::uint64_t seed) const {
+        std::uint64_t n = (std::uint64_t)(ms * units_per_ms_ + 0.5);
+        std::uint64_t sink = 0;
+        for (std::uint64_t i = 0; i < n; ++i) sink += unit(seed * 7919 + i);
+        return sink;
+    }
+
+private:
+    static constexpr std::size_t MEMORY_BYTES = std::size_t(64) << 20;
+    static constexpr std::size_t MEMORY_CHUNK = 32768;   // palabras por unidad (256 KB)
+    static constexpr std::uint32_t CACHE_SLOTS = 8192;   // 32 KB de índices
+    static constexpr int HASH_ROUNDS = 4096;
+    static constexpr int CACHE_STEPS = 4096;
+
+    static std::uint64_t mix(std::uint64_t x) {
+        // Finalizador de splitmix64
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // Una unidad de trabajo; 'k' varía el punto de partida
+    std::uint64_t unit(std::uint64_t k) const {
+        switch (kind_) {
+        case Workload::Hash: {
+            std::uint64_t x = k;
+            for (int i = 0; i < HASH_ROUNDS; ++i) x = mix(x);
+            return x;
+        }
+        case Workload::Memory: {
+            std::size_t chunks = stream_.size() / MEMORY_CHUNK;
+            const std::uint64_t* p = stream_.data() + (std::size_t)(k % chunks) * MEMORY_CHUNK;
+            std::uint64_t sum = 0;
+            for (std::size_t i = 0; i < MEMORY_CHUNK; ++i) sum += p[i];
+            return sum;
+        }
+        case Workload::Cache: {
+            std::uint32_t at = (std::uint32_t)(k % CACHE_SLOTS);
+            for (int i = 0; i < CACHE_STEPS; ++i) at = ring_[at];
+            return at;
+        }
+        case Workload::Sleep:
+            break;
+        }
+        return 0;
+    }
+
+    Workload kind_;
+    double units_per_ms_ = 0;
+    std::uint64_t sink_ = 0;
+    std::vector<std::uint64_t> stream_;  // Memory
+    std::vector<std::uint32_t> ring_;    // Cache
+};